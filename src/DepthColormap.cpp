@@ -0,0 +1,243 @@
+#include "DepthColormap.h"
+#include "SimdSupport.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr std::uint32_t INVALID = 0xFF000000u; // opaque black
+
+std::uint8_t toByte(double v) { return std::uint8_t(std::lround(std::clamp(v, 0.0, 1.0) * 255.0)); }
+
+// Google's polynomial approximation of the Turbo colormap
+void turbo(double x, double &r, double &g, double &b) {
+    const double x2 = x*x, x3 = x2*x, x4 = x3*x, x5 = x4*x;
+    r = 0.13572138 + 4.61539260*x - 42.66032258*x2 + 132.13108234*x3 - 152.94239396*x4 + 59.28637943*x5;
+    g = 0.09140261 + 2.19418839*x + 4.84296658*x2 - 14.18503333*x3 + 4.27729857*x4 + 2.82956604*x5;
+    b = 0.10667330 + 12.64194608*x - 60.58204836*x2 + 110.36276771*x3 - 89.90310912*x4 + 27.34824973*x5;
+}
+
+inline int indexOf(float v, float lo, float scale) {
+    float t = (v - lo) * scale;
+    if (!(t > 0.0f)) return 0;
+    if (t >= 255.0f) return 255;
+    return int(t);
+}
+
+void mapFloatScalar(const float *src, std::uint32_t *dst, int n, float lo, float scale,
+                    const std::uint32_t *lut, float &mn, float &mx) {
+    for (int i=0; i<n; ++i) {
+        float v = src[i];
+        if (v > 0.0f && v < std::numeric_limits<float>::infinity()) {
+            mn = std::min(mn, v);
+            mx = std::max(mx, v);
+            dst[i] = lut[indexOf(v, lo, scale)];
+        } else {
+            dst[i] = INVALID;
+        }
+    }
+}
+
+void mapMono16Scalar(const std::uint16_t *src, std::uint32_t *dst, int n, float lo, float scale,
+                     const std::uint32_t *lut, float &mn, float &mx) {
+    for (int i=0; i<n; ++i) {
+        float v = float(src[i]);
+        if (src[i] != 0) {
+            mn = std::min(mn, v);
+            mx = std::max(mx, v);
+            dst[i] = lut[indexOf(v, lo, scale)];
+        } else {
+            dst[i] = INVALID;
+        }
+    }
+}
+
+#ifdef YV_X86
+float hmin(__m128 v) {
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,0,3,2)));
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,3,0,1)));
+    return _mm_cvtss_f32(v);
+}
+float hmax(__m128 v) {
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,0,3,2)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,3,0,1)));
+    return _mm_cvtss_f32(v);
+}
+
+// SSE has no gather: indices and validity are computed 4-wide, lookups are scalar
+inline void lookup4Sse(__m128 v, __m128 valid, __m128 lo, __m128 scale, const std::uint32_t *lut, std::uint32_t *dst) {
+    // max(t, 0) returns 0 for NaN t, so every index is in range
+    __m128 t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(v, lo), scale), _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    alignas(16) std::int32_t idx[4];
+    alignas(16) std::int32_t ok[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(idx), _mm_cvttps_epi32(t));
+    _mm_store_si128(reinterpret_cast<__m128i*>(ok), _mm_castps_si128(valid));
+    for (int k=0; k<4; ++k) dst[k] = ok[k] ? lut[idx[k]] : INVALID;
+}
+
+void mapFloatSse2(const float *src, std::uint32_t *dst, int n, float lo, float scale,
+                  const std::uint32_t *lut, float &mn, float &mx) {
+    const __m128 vlo = _mm_set1_ps(lo), vscale = _mm_set1_ps(scale);
+    const __m128 zero = _mm_setzero_ps(), inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    __m128 vmn = _mm_set1_ps(mn), vmx = _mm_set1_ps(mx);
+    int i = 0;
+    for (; i+4<=n; i+=4) {
+        __m128 v = _mm_loadu_ps(src+i);
+        __m128 valid = _mm_and_ps(_mm_cmpgt_ps(v, zero), _mm_cmplt_ps(v, inf));
+        vmn = _mm_min_ps(vmn, _mm_or_ps(_mm_and_ps(valid, v), _mm_andnot_ps(valid, inf)));
+        vmx = _mm_max_ps(vmx, _mm_and_ps(valid, v));
+        lookup4Sse(v, valid, vlo, vscale, lut, dst+i);
+    }
+    mn = hmin(vmn);
+    mx = hmax(vmx);
+    mapFloatScalar(src+i, dst+i, n-i, lo, scale, lut, mn, mx);
+}
+
+void mapMono16Sse2(const std::uint16_t *src, std::uint32_t *dst, int n, float lo, float scale,
+                   const std::uint32_t *lut, float &mn, float &mx) {
+    const __m128 vlo = _mm_set1_ps(lo), vscale = _mm_set1_ps(scale);
+    const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    const __m128i zero = _mm_setzero_si128();
+    __m128 vmn = _mm_set1_ps(mn), vmx = _mm_set1_ps(mx);
+    int i = 0;
+    for (; i+8<=n; i+=8) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+        __m128i halves[2] = { _mm_unpacklo_epi16(raw, zero), _mm_unpackhi_epi16(raw, zero) };
+        for (int k=0; k<2; ++k) {
+            __m128 v = _mm_cvtepi32_ps(halves[k]);
+            __m128 valid = _mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(halves[k], zero), _mm_set1_epi32(-1)));
+            vmn = _mm_min_ps(vmn, _mm_or_ps(_mm_and_ps(valid, v), _mm_andnot_ps(valid, inf)));
+            vmx = _mm_max_ps(vmx, v);
+            lookup4Sse(v, valid, vlo, vscale, lut, dst+i+4*k);
+        }
+    }
+    mn = hmin(vmn);
+    mx = hmax(vmx);
+    mapMono16Scalar(src+i, dst+i, n-i, lo, scale, lut, mn, mx);
+}
+
+// AVX2: 8 samples per step, colors fetched with a hardware gather
+YV_TARGET("avx2")
+inline __m256i lookup8Avx2(__m256 v, __m256 valid, __m256 lo, __m256 scale, const std::uint32_t *lut) {
+    __m256 t = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(v, lo), scale), _mm256_setzero_ps()),
+                             _mm256_set1_ps(255.0f));
+    __m256i rgb = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut), _mm256_cvttps_epi32(t), 4);
+    return _mm256_blendv_epi8(_mm256_set1_epi32(int(INVALID)), rgb, _mm256_castps_si256(valid));
+}
+
+YV_TARGET("avx2")
+float hmin8(__m256 v) { return hmin(_mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1))); }
+YV_TARGET("avx2")
+float hmax8(__m256 v) { return hmax(_mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1))); }
+
+YV_TARGET("avx2")
+void mapFloatAvx2(const float *src, std::uint32_t *dst, int n, float lo, float scale,
+                  const std::uint32_t *lut, float &mn, float &mx) {
+    const __m256 vlo = _mm256_set1_ps(lo), vscale = _mm256_set1_ps(scale);
+    const __m256 zero = _mm256_setzero_ps(), inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256 vmn = _mm256_set1_ps(mn), vmx = _mm256_set1_ps(mx);
+    int i = 0;
+    for (; i+8<=n; i+=8) {
+        __m256 v = _mm256_loadu_ps(src+i);
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GT_OQ), _mm256_cmp_ps(v, inf, _CMP_LT_OQ));
+        vmn = _mm256_min_ps(vmn, _mm256_blendv_ps(inf, v, valid));
+        vmx = _mm256_max_ps(vmx, _mm256_and_ps(valid, v));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i), lookup8Avx2(v, valid, vlo, vscale, lut));
+    }
+    mn = hmin8(vmn);
+    mx = hmax8(vmx);
+    mapFloatScalar(src+i, dst+i, n-i, lo, scale, lut, mn, mx);
+}
+
+YV_TARGET("avx2")
+void mapMono16Avx2(const std::uint16_t *src, std::uint32_t *dst, int n, float lo, float scale,
+                   const std::uint32_t *lut, float &mn, float &mx) {
+    const __m256 vlo = _mm256_set1_ps(lo), vscale = _mm256_set1_ps(scale);
+    const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256 vmn = _mm256_set1_ps(mn), vmx = _mm256_set1_ps(mx);
+    int i = 0;
+    for (; i+8<=n; i+=8) {
+        __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i)));
+        __m256 v = _mm256_cvtepi32_ps(wide);
+        __m256 valid = _mm256_castsi256_ps(_mm256_xor_si256(_mm256_cmpeq_epi32(wide, _mm256_setzero_si256()),
+                                                            _mm256_set1_epi32(-1)));
+        vmn = _mm256_min_ps(vmn, _mm256_blendv_ps(inf, v, valid));
+        vmx = _mm256_max_ps(vmx, v);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i), lookup8Avx2(v, valid, vlo, vscale, lut));
+    }
+    mn = hmin8(vmn);
+    mx = hmax8(vmx);
+    mapMono16Scalar(src+i, dst+i, n-i, lo, scale, lut, mn, mx);
+}
+#endif
+
+struct Dispatch {
+    decltype(&mapFloatScalar) mapFloat = mapFloatScalar;
+    decltype(&mapMono16Scalar) mapMono16 = mapMono16Scalar;
+
+    Dispatch() {
+#ifdef YV_X86
+        // SSE2 is part of the x86-64 baseline
+        mapFloat = mapFloatSse2;
+        mapMono16 = mapMono16Sse2;
+        if (SimdSupport::hasAvx2()) {
+            mapFloat = mapFloatAvx2;
+            mapMono16 = mapMono16Avx2;
+        }
+#endif
+    }
+};
+
+const Dispatch &dispatch() {
+    static const Dispatch d;
+    return d;
+}
+
+}
+
+namespace DepthColormap {
+
+void buildLut(Map map, std::uint32_t lut[256]) {
+    for (int i=0; i<256; ++i) {
+        double x = i / 255.0;
+        double r = x, g = x, b = x;
+        if (map == Map::Jet) {
+            r = 1.5 - std::fabs(4.0*x - 3.0);
+            g = 1.5 - std::fabs(4.0*x - 2.0);
+            b = 1.5 - std::fabs(4.0*x - 1.0);
+        } else if (map == Map::Turbo) {
+            turbo(x, r, g, b);
+        }
+        lut[i] = 0xFF000000u | (std::uint32_t(toByte(r)) << 16) | (std::uint32_t(toByte(g)) << 8) | toByte(b);
+    }
+}
+
+const char *mapName(Map map) {
+    switch (map) {
+    case Map::Gray: return "gray";
+    case Map::Jet: return "jet";
+    case Map::Turbo: return "turbo";
+    }
+    return "gray";
+}
+
+bool mapFromName(const char *name, Map &map) {
+    for (Map m : {Map::Gray, Map::Jet, Map::Turbo}) {
+        if (std::strcmp(name, mapName(m)) == 0) { map = m; return true; }
+    }
+    return false;
+}
+
+void mapFloat(const float *src, std::uint32_t *dst, int n, float lo, float scale,
+              const std::uint32_t *lut, float &mn, float &mx) {
+    dispatch().mapFloat(src, dst, n, lo, scale, lut, mn, mx);
+}
+
+void mapMono16(const std::uint16_t *src, std::uint32_t *dst, int n, float lo, float scale,
+               const std::uint32_t *lut, float &mn, float &mx) {
+    dispatch().mapMono16(src, dst, n, lo, scale, lut, mn, mx);
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+// Colormap rendering of depth / float images (PixelFloat, PixelMono16).
+// Values are normalised to [lo, lo+255/scale] and looked up in a 256-entry
+// BGRA table (QImage::Format_RGB32 layout). Invalid samples (<= 0, NaN, inf)
+// are drawn black.
+namespace DepthColormap {
+
+enum class Map { Gray, Jet, Turbo };
+
+struct Settings {
+    bool enabled = false;
+    Map map = Map::Jet;
+    bool autoRange = true;  // track running min/max instead of near/far
+    float nearValue = 0.0f; // in the image's native units (e.g. m for float, mm for mono16)
+    float farValue = 0.0f;
+};
+
+void buildLut(Map map, std::uint32_t lut[256]);
+const char *mapName(Map map);
+bool mapFromName(const char *name, Map &map);
+
+// Map n samples to BGRA through lut and widen [mn, mx] with the valid samples seen.
+void mapFloat(const float *src, std::uint32_t *dst, int n, float lo, float scale,
+              const std::uint32_t *lut, float &mn, float &mx);
+void mapMono16(const std::uint16_t *src, std::uint32_t *dst, int n, float lo, float scale,
+               const std::uint32_t *lut, float &mn, float &mx);
+
+}
@@ -0,0 +1,195 @@
+#include "FlightRecorder.h"
+#include "FrameFile.h"
+#include "Trace.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <yarp/os/LogStream.h>
+#include <algorithm>
+#include <cstring>
+
+FlightRecorder::FlightRecorder(const Settings &s) : settings(s) {
+    settings.seconds = std::max(settings.seconds, 0.1);
+    settings.budgetMB = std::max(settings.budgetMB, 1);
+    worker = std::thread([this]() { workerLoop(); });
+}
+
+FlightRecorder::~FlightRecorder() {
+    {
+        QMutexLocker lock(&mutex);
+        stopping = true; // pending dumps are still written
+    }
+    wake.wakeAll();
+    worker.join();
+}
+
+void FlightRecorder::capture(const yarp::sig::Image &img, const yarp::os::Stamp &stamp, double now) {
+    const int w = int(img.width());
+    const int h = int(img.height());
+    const int ps = int(img.getPixelSize());
+    const qint64 rowBytes = qint64(w) * ps;
+    const qint64 raw = rowBytes * h;
+    if (raw <= 0) return;
+    Trace::Scope trace("flightCapture", stamp.getCount());
+    QByteArray data;
+    {
+        QMutexLocker lock(&mutex);
+        data = std::move(spare);
+    }
+    if (data.size() != raw) data = QByteArray(raw, Qt::Uninitialized);
+    // Packed rows: the port buffer's row padding is not kept
+    char *dst = data.data();
+    for (int y=0; y<h; ++y) {
+        std::memcpy(dst + y*rowBytes, img.getRawImage() + size_t(y)*img.getRowSize(), size_t(rowBytes));
+    }
+
+    QMutexLocker lock(&mutex);
+    Entry e;
+    e.data = std::move(data);
+    e.width = w;
+    e.height = h;
+    e.pixelCode = img.getPixelCode();
+    e.pixelSize = ps;
+    e.stamp = stamp;
+    e.arrival = now;
+    e.rawBytes = raw;
+    e.id = nextId++;
+    storedBytes += raw;
+    storedRawBytes += raw;
+    ring.push_back(std::move(e));
+    trim();
+    if (settings.compress) wake.wakeAll();
+}
+
+void FlightRecorder::trim() {
+    const qint64 budget = qint64(settings.budgetMB) * 1048576;
+    while (ring.size() > 1 && (storedBytes > budget || ring.back().arrival - ring.front().arrival > settings.seconds)) {
+        Entry &old = ring.front();
+        storedBytes -= old.data.size();
+        storedRawBytes -= old.rawBytes;
+        // Recycle one plain buffer: the next frame is most likely the same size
+        if (!old.compressed && old.data.isDetached()) spare = std::move(old.data);
+        ring.pop_front();
+    }
+}
+
+void FlightRecorder::dump(const QString &path) {
+    QMutexLocker lock(&mutex);
+    // Entries share their buffers with the ring: the snapshot copies no pixels
+    dumpQueue.emplace_back(path, std::vector<Entry>(ring.begin(), ring.end()));
+    wake.wakeAll();
+}
+
+QString FlightRecorder::dumpPath(const QString &dir, const QString &requested) {
+    QString name = requested.isEmpty()
+        ? "flight_" + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss_zzz")
+        : QFileInfo(requested).fileName(); // no directories, absolute or relative
+    if (name.isEmpty() || name.startsWith('.')) {
+        yWarning() << "Flight recorder: dump name" << requested.toStdString() << "rejected";
+        return QString();
+    }
+    if (!name.endsWith(".yvf", Qt::CaseInsensitive)) name += ".yvf";
+    return QDir(dir).filePath(name);
+}
+
+int FlightRecorder::frameCount() const {
+    QMutexLocker lock(&mutex);
+    return int(ring.size());
+}
+
+bool FlightRecorder::frame(int i, yarp::sig::FlexImage &img, yarp::os::Stamp &stamp, QByteArray &storage) const {
+    Entry e;
+    {
+        QMutexLocker lock(&mutex);
+        if (i < 0 || i >= int(ring.size())) return false;
+        e = ring[size_t(i)];
+    }
+    stamp = e.stamp;
+    return unpack(e, img, storage);
+}
+
+FlightRecorder::Stats FlightRecorder::stats() const {
+    QMutexLocker lock(&mutex);
+    Stats s;
+    s.frames = int(ring.size());
+    s.seconds = ring.empty() ? 0.0 : ring.back().arrival - ring.front().arrival;
+    s.bytes = storedBytes;
+    s.rawBytes = storedRawBytes;
+    s.dumps = dumpsWritten;
+    s.dumpFailed = dumpsFailed;
+    s.dumping = dumping || !dumpQueue.empty();
+    return s;
+}
+
+bool FlightRecorder::unpack(const Entry &e, yarp::sig::FlexImage &img, QByteArray &storage) {
+    storage = e.compressed ? qUncompress(e.data) : e.data;
+    if (storage.size() != e.rawBytes) return false;
+    img.setPixelCode(e.pixelCode);
+    img.setPixelSize(size_t(e.pixelSize));
+    img.setQuantum(1);
+    img.setExternal(reinterpret_cast<const unsigned char*>(storage.constData()), size_t(e.width), size_t(e.height));
+    return true;
+}
+
+void FlightRecorder::workerLoop() {
+    if (Trace::enabled()) Trace::setThreadName("flight recorder");
+    QMutexLocker lock(&mutex);
+    for (;;) {
+        if (!dumpQueue.empty()) {
+            // Dumps first: the operator is waiting for the file
+            auto job = std::move(dumpQueue.front());
+            dumpQueue.pop_front();
+            dumping = true;
+            lock.unlock();
+            writeDump(job.first, job.second);
+            job.second.clear();
+            lock.relock();
+            dumping = false;
+            continue;
+        }
+        if (stopping) break;
+        if (settings.compress && !ring.empty() && compressNextId <= ring.back().id) {
+            compressNextId = std::max(compressNextId, ring.front().id);
+            const quint64 id = compressNextId++;
+            const QByteArray raw = ring[size_t(id - ring.front().id)].data;
+            lock.unlock();
+            QByteArray packed;
+            {
+                Trace::Scope trace("flightCompress");
+                packed = qCompress(raw, 1);
+            }
+            lock.relock();
+            // The frame may have left the ring meanwhile; keep it raw if zlib gained little
+            if (!ring.empty() && id >= ring.front().id && packed.size() < raw.size() * 9 / 10) {
+                Entry &e = ring[size_t(id - ring.front().id)];
+                storedBytes += packed.size() - e.data.size();
+                e.data = std::move(packed);
+                e.compressed = true;
+            }
+            continue;
+        }
+        wake.wait(&mutex);
+    }
+}
+
+void FlightRecorder::writeDump(const QString &path, const std::vector<Entry> &frames) {
+    Trace::Scope trace("flightDump");
+    FrameFile::Writer writer;
+    bool ok = writer.open(path);
+    yarp::sig::FlexImage img;
+    QByteArray storage;
+    for (size_t i=0; ok && i<frames.size(); ++i) {
+        if (!unpack(frames[i], img, storage)) continue;
+        ok = writer.append(img, frames[i].stamp);
+    }
+    writer.close();
+    QMutexLocker lock(&mutex);
+    if (ok) {
+        dumpsWritten++;
+        yInfo() << "Flight recorder:" << frames.size() << "frames written to" << path.toStdString();
+    } else {
+        dumpsFailed++;
+        yError() << "Flight recorder: cannot write" << path.toStdString();
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <yarp/os/Stamp.h>
+#include <yarp/sig/Image.h>
+
+// Always-on pre-roll of the incoming stream: the last few seconds of native
+// frames with their envelope stamps, capped by a memory budget. capture()
+// runs on the port reader thread and only copies the rows; a worker thread
+// optionally compresses the stored frames (zlib, fastest level) and writes
+// dumps, so neither costs the reader or the GUI more than a snapshot of the
+// ring. Dumps are FrameFile recordings and play back with --replay.
+class FlightRecorder {
+public:
+    struct Settings {
+        double seconds = 10.0;  // pre-roll kept, by arrival time
+        int budgetMB = 256;     // stored bytes, oldest frames go first
+        bool compress = false;
+    };
+
+    struct Stats {
+        int frames{0};
+        double seconds{0.0};    // arrival span of the stored frames
+        qint64 bytes{0};        // as stored (after compression)
+        qint64 rawBytes{0};
+        quint64 dumps{0};       // dump files written
+        quint64 dumpFailed{0};
+        bool dumping{false};
+    };
+
+    explicit FlightRecorder(const Settings &s);
+    ~FlightRecorder();
+
+    // now: local arrival time (yarp::os::Time::now())
+    void capture(const yarp::sig::Image &img, const yarp::os::Stamp &stamp, double now);
+    // Writes the current ring to path on the worker thread; returns at once
+    void dump(const QString &path);
+    // Dump file in 'dir' for a requested name, which may come from any peer
+    // on the trigger port: reduced to a plain file name with the .yvf suffix.
+    // Empty request: a timestamped name. Null for names that are rejected.
+    static QString dumpPath(const QString &dir, const QString &requested);
+
+    int frameCount() const;
+    // Stored frame i (0 = oldest) as an image over 'storage', which must be
+    // kept alive while img is used
+    bool frame(int i, yarp::sig::FlexImage &img, yarp::os::Stamp &stamp, QByteArray &storage) const;
+    Stats stats() const;
+
+private:
+    struct Entry {
+        QByteArray data;     // packed rows, possibly compressed
+        bool compressed{false};
+        int width{0};
+        int height{0};
+        int pixelCode{0};
+        int pixelSize{0};
+        yarp::os::Stamp stamp;
+        double arrival{0.0};
+        qint64 rawBytes{0};
+        quint64 id{0};       // capture order, consecutive along the ring
+    };
+    static bool unpack(const Entry &e, yarp::sig::FlexImage &img, QByteArray &storage);
+    void trim();
+    void workerLoop();
+    void writeDump(const QString &path, const std::vector<Entry> &frames);
+
+    Settings settings;
+    mutable QMutex mutex;
+    QWaitCondition wake;
+    std::deque<Entry> ring;      // oldest first, guarded by mutex
+    qint64 storedBytes{0};       // guarded by mutex
+    qint64 storedRawBytes{0};
+    quint64 nextId{0};
+    quint64 compressNextId{0};   // first capture not yet looked at by the compressor
+    QByteArray spare;            // evicted raw buffer, reused by the next capture
+    std::deque<std::pair<QString, std::vector<Entry>>> dumpQueue;
+    bool dumping{false};
+    quint64 dumpsWritten{0};
+    quint64 dumpsFailed{0};
+    bool stopping{false};
+    std::thread worker;
+};
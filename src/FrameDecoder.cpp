@@ -0,0 +1,101 @@
+#include "FrameDecoder.h"
+#include "Trace.h"
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <algorithm>
+
+FrameDecoder::FrameDecoder() {
+    setThreads(3);
+}
+
+FrameDecoder::~FrameDecoder() {
+    pool.waitForDone();
+}
+
+void FrameDecoder::setThreads(int n) {
+    n = std::max(n, 1);
+    pool.setMaxThreadCount(n);
+    QMutexLocker lock(&mutex);
+    maxInFlight = 2 * n;
+    counters.threads = n;
+}
+
+bool FrameDecoder::submit(QByteArray data, const yarp::os::Stamp &stamp, double readTime, const QSize &target) {
+    quint64 seq;
+    {
+        QMutexLocker lock(&mutex);
+        if (counters.inFlight >= maxInFlight) {
+            counters.dropped++;
+            return false;
+        }
+        counters.inFlight++;
+        seq = nextSubmit++;
+    }
+    Result r;
+    r.stamp = stamp;
+    r.readTime = readTime;
+    pool.start([this, seq, data=std::move(data), r=std::move(r), target]() mutable {
+        decode(seq, data, std::move(r), target);
+    });
+    return true;
+}
+
+void FrameDecoder::decode(quint64 seq, const QByteArray &data, Result r, const QSize &target) {
+    Trace::nameThreadOnce("decoder");
+    QElapsedTimer timer;
+    timer.start();
+    {
+        Trace::Scope trace("decode", r.stamp.getCount());
+        QBuffer buffer;
+        buffer.setData(data);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader(&buffer);
+        r.format = reader.format();
+        r.fullSize = reader.size();
+        // JPEG scales by 1/2, 1/4, 1/8 while decoding; only worth it well below full size
+        if (!target.isEmpty() && r.fullSize.isValid() && reader.supportsOption(QImageIOHandler::ScaledSize)
+            && target.width() <= r.fullSize.width()*3/4 && target.height() <= r.fullSize.height()*3/4) {
+            reader.setScaledSize(r.fullSize.scaled(target, Qt::KeepAspectRatioByExpanding).boundedTo(r.fullSize));
+        }
+        r.image = reader.read();
+        if (!r.fullSize.isValid()) r.fullSize = r.image.size();
+    }
+    const double ms = timer.nsecsElapsed() / 1e6;
+
+    QMutexLocker lock(&mutex);
+    if (r.image.isNull()) counters.failed++;
+    else {
+        counters.decoded++;
+        counters.decodeMs = counters.decodeMs>0 ? 0.9*counters.decodeMs + 0.1*ms : ms;
+    }
+    if (seq != nextDeliver) counters.reordered++;
+    // Held frames keep their decode slot until delivered, so a slow frame
+    // stalls submit() instead of letting done grow
+    done.emplace(seq, std::move(r));
+    // One thread delivers at a time, which keeps the sink calls serialised
+    // and ordered; the sink itself runs without the lock
+    if (delivering) return;
+    delivering = true;
+    std::vector<Result> ready;
+    for (;;) {
+        for (auto it = done.begin(); it != done.end() && it->first == nextDeliver; it = done.erase(it), ++nextDeliver) {
+            counters.inFlight--;
+            if (!it->second.image.isNull()) ready.push_back(std::move(it->second));
+        }
+        if (ready.empty()) break;
+        lock.unlock();
+        for (Result &f : ready) {
+            if (sink) sink(std::move(f));
+        }
+        ready.clear();
+        lock.relock();
+    }
+    delivering = false;
+}
+
+FrameDecoder::Stats FrameDecoder::stats() const {
+    QMutexLocker lock(&mutex);
+    return counters;
+}
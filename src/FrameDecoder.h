@@ -0,0 +1,62 @@
+#pragma once
+#include <QByteArray>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QThreadPool>
+#include <functional>
+#include <map>
+#include <vector>
+#include <yarp/os/Stamp.h>
+
+// Decodes compressed frames (JPEG, PNG, anything QImageReader reads) on a
+// small pool so several frames can be in flight, then hands them out in
+// submission order. Formats with scaled decoding (JPEG) decode straight to
+// the requested size. submit() is called by the port reader thread; the
+// sink runs on a pool thread, one call at a time and in order.
+class FrameDecoder {
+public:
+    struct Result {
+        QImage image;
+        QSize fullSize;     // encoded resolution
+        QByteArray format;  // "jpeg", "png", ...
+        yarp::os::Stamp stamp;
+        double readTime{0.0};
+    };
+    using Sink = std::function<void(Result &&)>;
+
+    struct Stats {
+        quint64 decoded{0};
+        quint64 failed{0};
+        quint64 dropped{0};   // rejected with all decode slots busy
+        quint64 reordered{0}; // finished before an earlier frame and held back
+        int inFlight{0};      // submitted, not delivered yet (decoding or held for order)
+        double decodeMs{0.0}; // smoothed per frame
+        int threads{0};
+    };
+
+    FrameDecoder();
+    ~FrameDecoder();
+
+    // Pool size; up to twice as many frames are accepted before dropping
+    void setThreads(int n);
+    void setSink(Sink s) { sink = std::move(s); }
+    // target: decode scaled down to about this size when possible (null: full)
+    bool submit(QByteArray data, const yarp::os::Stamp &stamp, double readTime, const QSize &target);
+    // Waits for the frames in flight (delivered or not)
+    void waitForDone() { pool.waitForDone(); }
+    Stats stats() const;
+
+private:
+    void decode(quint64 seq, const QByteArray &data, Result r, const QSize &target);
+
+    QThreadPool pool;
+    Sink sink;
+    mutable QMutex mutex;
+    quint64 nextSubmit{0};  // guarded by mutex
+    quint64 nextDeliver{0};
+    std::map<quint64, Result> done; // decoded out of order, or failed (null image)
+    bool delivering{false};         // a pool thread is calling the sink
+    int maxInFlight{6};
+    Stats counters;
+};
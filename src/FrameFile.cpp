@@ -0,0 +1,299 @@
+#include "FrameFile.h"
+#include "Trace.h"
+#include <QMutexLocker>
+#include <yarp/os/LogStream.h>
+#include <algorithm>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace FrameFile {
+
+namespace {
+const char FILE_MAGIC[8] = {'Y','V','F','R','A','M','E','1'};
+const char INDEX_MAGIC[8] = {'Y','V','I','N','D','E','X','1'};
+
+quint64 alignUp(quint64 v) { return (v + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1); }
+// Largest pixel a YARP image uses (RGBA double), with room to spare
+constexpr std::uint32_t MAX_PIXEL_SIZE = 64;
+}
+
+bool Writer::open(const QString &path) {
+    close();
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        yError() << "Cannot create" << path.toStdString();
+        return false;
+    }
+    FileHeader h{};
+    std::memcpy(h.magic, FILE_MAGIC, sizeof(h.magic));
+    h.version = 1;
+    offset = file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    index.clear();
+    return offset == qint64(sizeof(h));
+}
+
+bool Writer::append(const yarp::sig::Image &img, const yarp::os::Stamp &stamp) {
+    if (!file.isOpen()) return false;
+    static const char zeros[RECORD_ALIGN] = {};
+    const qint64 start = qint64(alignUp(quint64(offset)));
+    if (start > offset && file.write(zeros, start - offset) != start - offset) return false;
+
+    FrameHeader h{};
+    h.magic = FRAME_MAGIC;
+    h.pixelCode = img.getPixelCode();
+    h.width = std::uint32_t(img.width());
+    h.height = std::uint32_t(img.height());
+    h.pixelSize = std::uint32_t(img.getPixelSize());
+    h.rowBytes = h.width * h.pixelSize;
+    h.dataBytes = std::uint64_t(h.rowBytes) * h.height;
+    h.seq = stamp.getCount();
+    h.stamp = stamp.getTime();
+    if (file.write(reinterpret_cast<const char*>(&h), sizeof(h)) != qint64(sizeof(h))) return false;
+    // YARP row padding is dropped; the reader restores the layout with quantum 1
+    const unsigned char *src = img.getRawImage();
+    const size_t stride = img.getRowSize();
+    for (std::uint32_t y=0; y<h.height; ++y) {
+        if (file.write(reinterpret_cast<const char*>(src + y*stride), h.rowBytes) != qint64(h.rowBytes)) return false;
+    }
+    offset = start + qint64(sizeof(h) + h.dataBytes);
+    index.push_back(IndexEntry{std::uint64_t(start), h.stamp, h.seq, 0});
+    return true;
+}
+
+void Writer::close() {
+    if (!file.isOpen()) return;
+    Footer f{};
+    f.indexOffset = std::uint64_t(offset);
+    f.frameCount = index.size();
+    std::memcpy(f.magic, INDEX_MAGIC, sizeof(f.magic));
+    file.write(reinterpret_cast<const char*>(index.data()), qint64(index.size()*sizeof(IndexEntry)));
+    file.write(reinterpret_cast<const char*>(&f), sizeof(f));
+    file.close();
+}
+
+bool QueuedWriter::open(const QString &path, qint64 maxQueuedBytes) {
+    close();
+    if (!writer.open(path)) return false;
+    {
+        QMutexLocker lock(&mutex);
+        maxBytes = std::max<qint64>(maxQueuedBytes, 1);
+        counters = Stats();
+        counters.bytes = writer.bytes();
+        accepting = true;
+        stopping = false;
+    }
+    worker = std::thread([this]() { workerLoop(); });
+    return true;
+}
+
+void QueuedWriter::close() {
+    {
+        QMutexLocker lock(&mutex);
+        accepting = false;
+        stopping = true; // queued frames are still written
+    }
+    wake.wakeAll();
+    if (worker.joinable()) worker.join();
+    writer.close();
+}
+
+bool QueuedWriter::isOpen() const {
+    QMutexLocker lock(&mutex);
+    return accepting;
+}
+
+QueuedWriter::Stats QueuedWriter::stats() const {
+    QMutexLocker lock(&mutex);
+    Stats s = counters;
+    s.queued = queue.size();
+    return s;
+}
+
+bool QueuedWriter::append(const yarp::sig::Image &img, const yarp::os::Stamp &stamp) {
+    const int w = int(img.width());
+    const int h = int(img.height());
+    const int ps = int(img.getPixelSize());
+    const qint64 rowBytes = qint64(w) * ps;
+    const qint64 raw = rowBytes * h;
+    if (raw <= 0) return false;
+    QByteArray data;
+    {
+        QMutexLocker lock(&mutex);
+        if (!accepting) return false;
+        if (queuedBytes + raw > maxBytes && !queue.empty()) {
+            counters.dropped++;
+            return false;
+        }
+        data = std::move(spare);
+    }
+    if (data.size() != raw) data = QByteArray(raw, Qt::Uninitialized);
+    // Packed rows, as they go to the file; the port buffer is reused once onRead returns
+    char *dst = data.data();
+    for (int y=0; y<h; ++y) {
+        std::memcpy(dst + y*rowBytes, img.getRawImage() + size_t(y)*img.getRowSize(), size_t(rowBytes));
+    }
+    QMutexLocker lock(&mutex);
+    if (!accepting) return false;
+    queuedBytes += raw;
+    queue.push_back(Record{std::move(data), w, h, img.getPixelCode(), ps, stamp});
+    wake.wakeAll();
+    return true;
+}
+
+void QueuedWriter::workerLoop() {
+    if (Trace::enabled()) Trace::setThreadName("stream recorder");
+    yarp::sig::FlexImage img;
+    QMutexLocker lock(&mutex);
+    for (;;) {
+        if (queue.empty()) {
+            if (stopping) break;
+            wake.wait(&mutex);
+            continue;
+        }
+        Record r = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        img.setPixelCode(r.pixelCode);
+        img.setPixelSize(size_t(r.pixelSize));
+        img.setQuantum(1);
+        img.setExternal(reinterpret_cast<const unsigned char*>(r.data.constData()), size_t(r.width), size_t(r.height));
+        bool ok;
+        {
+            Trace::Scope trace("recordStream", r.stamp.getCount());
+            ok = writer.append(img, r.stamp);
+        }
+        if (!ok) {
+            yError() << "Stream recording failed, closing" << writer.fileName().toStdString();
+            writer.close();
+        }
+        lock.relock();
+        queuedBytes -= r.data.size();
+        if (ok) {
+            counters.frames = writer.frames();
+            counters.bytes = writer.bytes();
+            if (r.data.isDetached()) spare = std::move(r.data);
+        } else {
+            // Nothing more can be written: refuse new frames and drop the rest
+            counters.failed = true;
+            counters.dropped += queue.size();
+            accepting = false;
+            queue.clear();
+            queuedBytes = 0;
+        }
+    }
+}
+
+bool Reader::open(const QString &path) {
+    close();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        yError() << "Cannot open" << path.toStdString();
+        return false;
+    }
+    size = quint64(file.size());
+    base = size >= sizeof(FileHeader) ? file.map(0, qint64(size)) : nullptr;
+    if (!base || std::memcmp(base, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        yError() << path.toStdString() << "is not a frame recording";
+        close();
+        return false;
+    }
+#ifdef Q_OS_UNIX
+    // Playback walks the file front to back: favour aggressive read-ahead
+    madvise(const_cast<uchar*>(base), size_t(size), MADV_SEQUENTIAL);
+#endif
+    if (!loadIndex() && !scanRecords()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void Reader::close() {
+    if (base) file.unmap(const_cast<uchar*>(base));
+    base = nullptr;
+    size = 0;
+    index.clear();
+    if (file.isOpen()) file.close();
+}
+
+bool Reader::validRecord(quint64 offset, quint64 limit) const {
+    if (offset < sizeof(FileHeader) || offset > limit || limit - offset < sizeof(FrameHeader)) return false;
+    FrameHeader h;
+    std::memcpy(&h, base + offset, sizeof(h));
+    if (h.magic != FRAME_MAGIC || h.width == 0 || h.height == 0) return false;
+    if (h.pixelSize == 0 || h.pixelSize > MAX_PIXEL_SIZE) return false;
+    // In 64 bits: width and height are 32-bit, so none of these products overflow
+    if (h.rowBytes != std::uint64_t(h.width) * h.pixelSize) return false;
+    if (h.dataBytes != std::uint64_t(h.rowBytes) * h.height) return false;
+    return h.dataBytes <= limit - offset - sizeof(FrameHeader);
+}
+
+bool Reader::loadIndex() {
+    if (size < sizeof(FileHeader) + sizeof(Footer)) return false;
+    Footer f;
+    std::memcpy(&f, base + size - sizeof(Footer), sizeof(f));
+    if (std::memcmp(f.magic, INDEX_MAGIC, sizeof(f.magic)) != 0) return false;
+    const quint64 indexEnd = size - sizeof(Footer);
+    if (f.indexOffset < sizeof(FileHeader) || f.indexOffset > indexEnd) return false;
+    if (f.frameCount != (indexEnd - f.indexOffset) / sizeof(IndexEntry)
+        || f.frameCount * sizeof(IndexEntry) != indexEnd - f.indexOffset) return false;
+    index.resize(size_t(f.frameCount));
+    std::memcpy(index.data(), base + f.indexOffset, index.size()*sizeof(IndexEntry));
+    // Keep the frames up to the first bad record
+    for (size_t i=0; i<index.size(); ++i) {
+        if (!validRecord(index[i].offset, f.indexOffset)) {
+            yWarning() << file.fileName().toStdString() << "frame" << i << "of" << index.size() << "is corrupt, playing the frames before it";
+            index.resize(i);
+            break;
+        }
+    }
+    return !index.empty();
+}
+
+bool Reader::scanRecords() {
+    // Unterminated recording: recover every complete frame record
+    yWarning() << file.fileName().toStdString() << "has no index, scanning frames";
+    index.clear();
+    quint64 pos = alignUp(sizeof(FileHeader));
+    while (validRecord(pos, size)) {
+        FrameHeader h;
+        std::memcpy(&h, base + pos, sizeof(h));
+        index.push_back(IndexEntry{pos, h.stamp, h.seq, 0});
+        pos = alignUp(pos + sizeof(h) + h.dataBytes);
+    }
+    return !index.empty();
+}
+
+const FrameHeader *Reader::header(size_t i) const {
+    return reinterpret_cast<const FrameHeader*>(base + index[i].offset);
+}
+
+bool Reader::frame(size_t i, yarp::sig::FlexImage &img, yarp::os::Stamp &stamp) const {
+    if (i >= index.size()) return false;
+    // Records were validated by open()
+    const FrameHeader *h = header(i);
+    img.setPixelCode(h->pixelCode);
+    img.setPixelSize(h->pixelSize);
+    img.setQuantum(1);
+    img.setExternal(reinterpret_cast<const unsigned char*>(h + 1), h->width, h->height);
+    if (img.getRowSize() != h->rowBytes) return false;
+    stamp = yarp::os::Stamp(h->seq, h->stamp);
+    return true;
+}
+
+void Reader::prefetch(size_t i) const {
+#ifdef Q_OS_UNIX
+    if (i >= index.size()) return;
+    static const quint64 page = quint64(sysconf(_SC_PAGESIZE));
+    const quint64 begin = index[i].offset & ~(page - 1);
+    const quint64 end = index[i].offset + sizeof(FrameHeader) + header(i)->dataBytes;
+    madvise(const_cast<uchar*>(base + begin), size_t(std::min(end, size) - begin), MADV_WILLNEED);
+#else
+    Q_UNUSED(i);
+#endif
+}
+
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <cstdint>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <yarp/os/Stamp.h>
+#include <yarp/sig/Image.h>
+
+// Single-file stream recording: a file header, frames in their native YARP
+// pixel layout (rows tightly packed, each record 64-byte aligned) and a
+// trailing seek index with the envelope stamps.
+//
+//   FileHeader | FrameHeader data [pad] | ... | IndexEntry * n | Footer
+//
+// A file whose writer never got to close() has no footer; the reader then
+// rebuilds the index by walking the frame records.
+namespace FrameFile {
+
+struct FileHeader {
+    char magic[8];          // "YVFRAME1"
+    std::uint32_t version;
+    std::uint32_t reserved;
+};
+
+struct FrameHeader {
+    std::uint32_t magic;    // FRAME_MAGIC
+    std::int32_t pixelCode; // YARP vocab
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t pixelSize;
+    std::uint32_t rowBytes; // width * pixelSize, no padding
+    std::uint64_t dataBytes;
+    std::int32_t seq;       // envelope sequence number
+    std::uint32_t reserved0;
+    double stamp;           // envelope time (s)
+    std::uint8_t reserved1[16];
+};
+
+struct IndexEntry {
+    std::uint64_t offset;   // of the FrameHeader
+    double stamp;
+    std::int32_t seq;
+    std::uint32_t reserved;
+};
+
+struct Footer {
+    std::uint64_t indexOffset;
+    std::uint64_t frameCount;
+    char magic[8];          // "YVINDEX1"
+};
+
+static_assert(sizeof(FileHeader) == 16, "FileHeader layout");
+static_assert(sizeof(FrameHeader) == 64, "FrameHeader layout");
+static_assert(sizeof(IndexEntry) == 24, "IndexEntry layout");
+static_assert(sizeof(Footer) == 24, "Footer layout");
+
+constexpr std::uint32_t FRAME_MAGIC = 0x52465659; // "YVFR"
+constexpr std::uint64_t RECORD_ALIGN = 64;
+
+// Sequential writer. Not thread safe: the caller serialises append().
+class Writer {
+public:
+    Writer() = default;
+    ~Writer() { close(); }
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    bool open(const QString &path);
+    bool append(const yarp::sig::Image &img, const yarp::os::Stamp &stamp);
+    // Writes the index and footer.
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+    quint64 frames() const { return index.size(); }
+    quint64 bytes() const { return quint64(offset); }
+    QString fileName() const { return file.fileName(); }
+
+private:
+    QFile file;
+    qint64 offset{0};
+    std::vector<IndexEntry> index;
+};
+
+// Writer on its own thread, for recording from the port reader: append()
+// only copies the rows into a queue and returns, so disk stalls never reach
+// the caller. Frames beyond maxQueuedBytes are dropped and counted. On a
+// write error the file is closed and further frames are refused.
+class QueuedWriter {
+public:
+    struct Stats {
+        quint64 frames{0};  // written
+        quint64 bytes{0};   // file size so far
+        quint64 queued{0};  // waiting for the writer thread
+        quint64 dropped{0}; // queue full
+        bool failed{false};
+    };
+
+    QueuedWriter() = default;
+    ~QueuedWriter() { close(); }
+    QueuedWriter(const QueuedWriter &) = delete;
+    QueuedWriter &operator=(const QueuedWriter &) = delete;
+
+    bool open(const QString &path, qint64 maxQueuedBytes = qint64(256) << 20);
+    // Thread safe; false if the frame was dropped or nothing is open
+    bool append(const yarp::sig::Image &img, const yarp::os::Stamp &stamp);
+    // Writes the frames still queued, then the index and footer
+    void close();
+    bool isOpen() const;
+    Stats stats() const;
+
+private:
+    struct Record {
+        QByteArray data;    // packed rows
+        int width{0};
+        int height{0};
+        int pixelCode{0};
+        int pixelSize{0};
+        yarp::os::Stamp stamp;
+    };
+    void workerLoop();
+
+    Writer writer;          // writer thread only while it runs
+    mutable QMutex mutex;
+    QWaitCondition wake;
+    std::deque<Record> queue; // guarded by mutex
+    qint64 queuedBytes{0};
+    qint64 maxBytes{0};
+    QByteArray spare;       // written buffer, reused by the next append
+    bool accepting{false};
+    bool stopping{false};
+    Stats counters;
+    std::thread worker;
+};
+
+// Memory-mapped reader. Frames point straight into the mapping. Headers,
+// index and record sizes are checked against the file when it is opened,
+// so a truncated or corrupt recording ends early instead of reading out of
+// bounds.
+class Reader {
+public:
+    Reader() = default;
+    ~Reader() { close(); }
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    bool open(const QString &path);
+    void close();
+    size_t frameCount() const { return index.size(); }
+    const IndexEntry &entry(size_t i) const { return index[i]; }
+
+    // Wraps frame i without copying; img stays valid while the reader is open.
+    bool frame(size_t i, yarp::sig::FlexImage &img, yarp::os::Stamp &stamp) const;
+    // Hint the kernel to page in frame i ahead of use.
+    void prefetch(size_t i) const;
+
+private:
+    bool loadIndex();
+    bool scanRecords();
+    // Record at offset is a complete frame ending at or before limit
+    bool validRecord(quint64 offset, quint64 limit) const;
+    const FrameHeader *header(size_t i) const;
+
+    QFile file;
+    const uchar *base{nullptr};
+    quint64 size{0};
+    std::vector<IndexEntry> index;
+};
+
+}
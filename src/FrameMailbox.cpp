@@ -0,0 +1,22 @@
+#include "FrameMailbox.h"
+
+bool FrameMailbox::publish() {
+    std::uint8_t prev = middle.exchange(std::uint8_t(backIdx | FRESH), std::memory_order_acq_rel);
+    backIdx = prev & INDEX_MASK;
+    publishedCount.fetch_add(1, std::memory_order_relaxed);
+    if (prev & FRESH) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool FrameMailbox::take(Frame &out) {
+    if (!(middle.load(std::memory_order_acquire) & FRESH)) return false;
+    std::uint8_t prev = middle.exchange(frontIdx, std::memory_order_acq_rel);
+    frontIdx = prev & INDEX_MASK;
+    // Share (not copy) the pixels; the slot keeps a reference until the writer
+    // overwrites it, at which point QImage's atomic refcount releases it.
+    out = slots[frontIdx];
+    return true;
+}
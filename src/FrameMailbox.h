@@ -0,0 +1,48 @@
+#pragma once
+#include <QImage>
+#include <atomic>
+#include <cstdint>
+#include <yarp/os/Stamp.h>
+
+// Latest-frame mailbox between the port reader thread and the GUI thread.
+// Triple buffer: the writer owns one slot, the reader owns one slot and the
+// third one is the "middle" slot exchanged atomically. Publishing a frame that
+// the reader has not taken yet overwrites it and counts it as dropped, so no
+// backlog can ever build up.
+class FrameMailbox {
+public:
+    struct Frame {
+        QImage image;
+        yarp::os::Stamp stamp;
+        double readTime{0.0};    // yarp::os::Time::now() at onRead entry
+        double publishTime{0.0}; // ... once converted and published
+        QSize fullSize;          // stream resolution; image is smaller if reduced at ingest
+    };
+
+    FrameMailbox() = default;
+    FrameMailbox(const FrameMailbox &) = delete;
+    FrameMailbox &operator=(const FrameMailbox &) = delete;
+
+    // Writer side (single producer). Fill back() then call publish().
+    Frame &back() { return slots[backIdx]; }
+    // Returns true if a frame not yet taken by the reader was overwritten.
+    bool publish();
+
+    // Reader side (single consumer). Returns false if nothing new was published.
+    bool take(Frame &out);
+    bool hasNew() const { return (middle.load(std::memory_order_acquire) & FRESH) != 0; }
+
+    quint64 published() const { return publishedCount.load(std::memory_order_relaxed); }
+    quint64 dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::uint8_t FRESH = 0x4;
+    static constexpr std::uint8_t INDEX_MASK = 0x3;
+
+    Frame slots[3];
+    std::uint8_t backIdx{0};   // writer-owned
+    std::uint8_t frontIdx{1};  // reader-owned
+    std::atomic<std::uint8_t> middle{2};
+    std::atomic<quint64> publishedCount{0};
+    std::atomic<quint64> droppedCount{0};
+};
@@ -0,0 +1,134 @@
+#include "FramePool.h"
+#include <QMutexLocker>
+#include <cstdlib>
+#include <new>
+
+namespace {
+constexpr size_t ALIGN = 64;
+
+// Header stored in front of every buffer; the pixel data follows at ALIGN.
+struct Block;
+}
+
+struct FramePool::Impl {
+    struct FreeList {
+        std::vector<Block*> blocks;
+        quint64 lastUse{0}; // useClock value of the last take() or give()
+    };
+    mutable QMutex mutex;
+    std::unordered_map<size_t, FreeList> freeLists;
+    quint64 useClock{0};
+    Stats stats;
+
+    Block *take(size_t bytes);
+    void give(Block *b);
+    void trimToBudget();
+};
+
+namespace {
+struct Block {
+    std::weak_ptr<FramePool::Impl> owner;
+    size_t capacity;
+    uchar *data() { return reinterpret_cast<uchar*>(this) + ALIGN; }
+};
+static_assert(sizeof(Block) <= ALIGN, "Block header must fit in the alignment pad");
+
+Block *allocBlock(size_t bytes) {
+    size_t total = ((ALIGN + bytes + ALIGN - 1) / ALIGN) * ALIGN;
+    void *mem = ::operator new(total, std::align_val_t(ALIGN));
+    Block *b = new (mem) Block;
+    b->capacity = bytes;
+    return b;
+}
+
+void freeBlock(Block *b) {
+    b->~Block();
+    ::operator delete(static_cast<void*>(b), std::align_val_t(ALIGN));
+}
+
+void releaseBlock(void *info) {
+    Block *b = static_cast<Block*>(info);
+    if (auto pool = b->owner.lock()) pool->give(b);
+    else freeBlock(b);
+}
+}
+
+Block *FramePool::Impl::take(size_t bytes) {
+    QMutexLocker lock(&mutex);
+    FreeList &list = freeLists[bytes];
+    list.lastUse = ++useClock;
+    if (!list.blocks.empty()) {
+        Block *b = list.blocks.back();
+        list.blocks.pop_back();
+        stats.hits++;
+        stats.freeBytes -= qint64(bytes);
+        return b;
+    }
+    stats.misses++;
+    stats.residentBytes += qint64(bytes);
+    return nullptr;
+}
+
+void FramePool::Impl::give(Block *b) {
+    {
+        QMutexLocker lock(&mutex);
+        FreeList &list = freeLists[b->capacity];
+        if ((int)list.blocks.size() < MAX_FREE_PER_SIZE && qint64(b->capacity) <= MAX_FREE_BYTES) {
+            list.blocks.push_back(b);
+            list.lastUse = ++useClock;
+            stats.freeBytes += qint64(b->capacity);
+            trimToBudget();
+            return;
+        }
+        stats.residentBytes -= qint64(b->capacity);
+    }
+    freeBlock(b);
+}
+
+void FramePool::Impl::trimToBudget() {
+    // Evict idle buffers of the size least recently asked for until the
+    // free lists fit the budget again; sizes no longer in use go first
+    while (stats.freeBytes > MAX_FREE_BYTES) {
+        FreeList *oldest = nullptr;
+        for (auto &kv : freeLists) {
+            if (kv.second.blocks.empty()) continue;
+            if (!oldest || kv.second.lastUse < oldest->lastUse) oldest = &kv.second;
+        }
+        if (!oldest) break;
+        Block *b = oldest->blocks.back();
+        oldest->blocks.pop_back();
+        stats.residentBytes -= qint64(b->capacity);
+        stats.freeBytes -= qint64(b->capacity);
+        freeBlock(b);
+    }
+    // Drop the bookkeeping of sizes that have nothing left to hand out
+    for (auto it = freeLists.begin(); it != freeLists.end();) {
+        if (it->second.blocks.empty() && it->second.lastUse + 64 < useClock) it = freeLists.erase(it);
+        else ++it;
+    }
+}
+
+FramePool::FramePool() : d(std::make_shared<Impl>()) {}
+
+FramePool &FramePool::instance() {
+    static FramePool pool;
+    return pool;
+}
+
+QImage FramePool::acquire(int w, int h, QImage::Format fmt) {
+    if (w<=0 || h<=0) return QImage();
+    const int depth = QImage::toPixelFormat(fmt).bitsPerPixel();
+    const qsizetype bpl = ((qsizetype(w) * depth / 8 + 31) / 32) * 32;
+    const size_t bytes = size_t(bpl) * size_t(h);
+    Block *b = d->take(bytes);
+    if (!b) {
+        b = allocBlock(bytes);
+        b->owner = d;
+    }
+    return QImage(b->data(), w, h, bpl, fmt, releaseBlock, b);
+}
+
+FramePool::Stats FramePool::stats() const {
+    QMutexLocker lock(&d->mutex);
+    return d->stats;
+}
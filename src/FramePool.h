@@ -0,0 +1,36 @@
+#pragma once
+#include <QImage>
+#include <QMutex>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Size-keyed pool of frame buffers that survive across frames.
+// acquire() returns a QImage wrapping a pooled buffer; when the last QImage
+// sharing it goes away the buffer goes back to the pool instead of the heap.
+// Several sizes are kept at once (mosaic tiles, ingest reduction); idle
+// buffers beyond MAX_FREE_BYTES are freed least recently used size first.
+class FramePool {
+public:
+    struct Stats {
+        quint64 hits{0};
+        quint64 misses{0};
+        qint64 residentBytes{0}; // pooled buffers alive (in use + free)
+        qint64 freeBytes{0};     // of which idle in the free lists
+    };
+
+    static FramePool &instance();
+
+    // Rows are padded to 32 bytes; contents are uninitialised.
+    QImage acquire(int w, int h, QImage::Format fmt);
+    Stats stats() const;
+
+    static constexpr int MAX_FREE_PER_SIZE = 4;
+    static constexpr qint64 MAX_FREE_BYTES = qint64(256) << 20;
+
+    struct Impl; // opaque; pooled buffers keep a weak reference to it
+
+private:
+    FramePool();
+    std::shared_ptr<Impl> d;
+};
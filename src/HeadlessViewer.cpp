@@ -0,0 +1,147 @@
+#include "HeadlessViewer.h"
+#include "ReceiverStats.h"
+#include "Trace.h"
+#include <QCoreApplication>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+#include <csignal>
+
+namespace {
+volatile std::sig_atomic_t quitRequested = 0;
+void onQuitSignal(int) { quitRequested = 1; }
+}
+
+HeadlessViewer::HeadlessViewer(const YarpViewOptions &opt, QObject *parent)
+    : QObject(parent), options(opt) {
+    std::signal(SIGINT, onQuitSignal);
+    std::signal(SIGTERM, onQuitSignal);
+    if (!options.mosaicInputs.empty()) yWarning() << "--input tiles are not shown with --headless, ignored";
+
+    receiver.setConversion(false);
+    ImageReceiver::ReadPolicy policy = ImageReceiver::ReadPolicy::Latest;
+    if (!ImageReceiver::readPolicyFromName(options.readPolicy.c_str(), policy)) {
+        yWarning() << "Unknown policy" << options.readPolicy << "- using latest";
+    }
+    receiver.setReadPolicy(policy, options.queueDepth);
+    if (options.flightSeconds > 0.0) {
+        FlightRecorder::Settings fs;
+        fs.seconds = options.flightSeconds;
+        fs.budgetMB = options.flightMB;
+        fs.compress = options.flightCompress;
+        flight = std::make_unique<FlightRecorder>(fs);
+        receiver.setFlightRecorder(flight.get());
+        if (!flightPort.open(options.flightTriggerPortName)) yError() << "Cannot open flight recorder trigger port" << options.flightTriggerPortName;
+    }
+    if (options.relayEnabled) {
+        StreamRelay::Settings rs;
+        rs.scale = options.relayScale;
+        rs.maxRate = options.relayRate;
+        rs.jpegQuality = options.relayJpegQuality;
+        relay = std::make_unique<StreamRelay>(rs);
+        if (relay->open(options.relayOutPortName)) receiver.setRelay(relay.get());
+        else relay.reset();
+    }
+    if (!options.replayFile.empty()) {
+        running = receiver.openReplay(QString::fromStdString(options.replayFile), options.replaySpeed, options.replayLoop);
+    } else {
+        receiver.setCompressedInput(options.compressedInput, options.decodeThreads);
+        running = receiver.open(options.imgInputPortName, true);
+        if (running && !options.connectSource.empty()) receiver.connectSource(options.connectSource, options.carrier);
+    }
+    if (!options.recordFile.empty()) receiver.startRecording(QString::fromStdString(options.recordFile));
+    connect(&receiver, &ImageReceiver::frameAvailable, this, &HeadlessViewer::onFrameAvailable);
+
+    if (options.statsEnabled) {
+        if (!statsPort.open(options.statsOutPortName)) {
+            yError() << "Cannot open stats output port" << options.statsOutPortName;
+        } else {
+            statsTimer = new QTimer(this);
+            statsTimer->setInterval(options.statsPeriodMs);
+            connect(statsTimer, &QTimer::timeout, this, &HeadlessViewer::publishStats);
+            statsTimer->start();
+        }
+    }
+    statusTimer = new QTimer(this);
+    statusTimer->setInterval(STATUS_PERIOD_MS);
+    connect(statusTimer, &QTimer::timeout, this, &HeadlessViewer::updateStatus);
+    statusTimer->start();
+    yInfo() << "Running headless on" << (options.replayFile.empty() ? options.imgInputPortName : options.replayFile);
+}
+
+HeadlessViewer::~HeadlessViewer() {
+    receiver.close();
+    logSummary();
+    if (options.statsEnabled) statsPort.close();
+    if (flight) flightPort.close();
+}
+
+void HeadlessViewer::onFrameAvailable() {
+    // Same stages as the window up to the hand-over; there is no render stage
+    FrameMailbox::Frame f;
+    while (receiver.takeLatest(f)) {
+        Trace::Scope trace("pullFrame", f.stamp.getCount());
+        const double now = yarp::os::Time::now();
+        lastImgW = f.fullSize.width();
+        lastImgH = f.fullSize.height();
+        const bool live = f.stamp.isValid() && !receiver.isReplaying();
+        if (live) {
+            latency.stage(LatencyStats::Transport).add((f.readTime - f.stamp.getTime())*1000.0);
+            latency.stage(LatencyStats::Total).add((now - f.stamp.getTime())*1000.0);
+        }
+        latency.stage(LatencyStats::Convert).add((f.publishTime - f.readTime)*1000.0);
+        latency.stage(LatencyStats::Queue).add((now - f.publishTime)*1000.0);
+    }
+}
+
+void HeadlessViewer::updateStatus() {
+    if (quitRequested) {
+        QCoreApplication::quit();
+        return;
+    }
+    pollFlightTrigger();
+    if (++statusTicks >= SUMMARY_TICKS) {
+        statusTicks = 0;
+        logSummary();
+    }
+}
+
+void HeadlessViewer::pollFlightTrigger() {
+    // Any message dumps; a string in it names the file
+    if (!flight) return;
+    ReceiverStats::pollFlightTrigger(flightPort, *flight, QString::fromStdString(options.flightDir));
+}
+
+void HeadlessViewer::logSummary() {
+    QString line = QString("%1 Hz, %2x%3 %4, received %5, transport dropped %6, latency %7 ms")
+                   .arg(receiver.arrivalStats().hz(),0,'f',1).arg(lastImgW).arg(lastImgH)
+                   .arg(ImageReceiver::pixelCodeName(receiver.pixelCode()))
+                   .arg(receiver.framesReceived()).arg(receiver.transportDropped())
+                   .arg(latency.summary(latency.stage(LatencyStats::Total).count() ? LatencyStats::Total : LatencyStats::Queue));
+    if (receiver.isRecording()) {
+        const FrameFile::QueuedWriter::Stats ss = receiver.recordingStats();
+        line += QString(", recorded %1 frames (%2 MB, %3 dropped)").arg(ss.frames).arg(ss.bytes / 1e6,0,'f',1).arg(ss.dropped);
+    }
+    if (flight) {
+        const FlightRecorder::Stats fs = flight->stats();
+        line += QString(", flight %1 frames %2 s, %3 dumps").arg(fs.frames).arg(fs.seconds,0,'f',1).arg(fs.dumps);
+    }
+    if (relay) {
+        const StreamRelay::Stats os = relay->stats();
+        line += QString(", out %1x%2 %3 sent").arg(os.size.width()).arg(os.size.height()).arg(os.published);
+    }
+    yInfo() << line.toStdString();
+}
+
+void HeadlessViewer::publishStats() {
+    // The window's stats:o layout, without the display entries
+    yarp::os::Bottle &b = statsPort.prepare();
+    b.clear();
+    ReceiverStats::addPortRate(b, receiver.arrivalStats());
+    ReceiverStats::addLatency(b, latency, {LatencyStats::Total, LatencyStats::Transport, LatencyStats::Convert,
+                                           LatencyStats::Queue});
+    ReceiverStats::addReceiver(b, receiver, lastImgW, lastImgH);
+    if (flight) ReceiverStats::addFlight(b, flight->stats());
+    if (relay) ReceiverStats::addRelay(b, relay->stats());
+    ReceiverStats::addQueue(b, receiver.queueStats());
+    statsPort.write();
+}
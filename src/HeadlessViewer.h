@@ -0,0 +1,52 @@
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include <memory>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
+#include "Options.h"
+#include "ImageReceiver.h"
+#include "FlightRecorder.h"
+#include "StreamRelay.h"
+#include "LatencyStats.h"
+
+// The receive side of the viewer without a window, for machines without a
+// display: port (or replay), stream recording, flight recorder, stats:o and
+// latency up to the point a frame would be handed to the display. Frames
+// are not converted, so the only per-frame work left is the bookkeeping.
+// Runs under QCoreApplication; SIGINT/SIGTERM quit cleanly so recordings
+// are closed.
+class HeadlessViewer : public QObject {
+    Q_OBJECT
+public:
+    explicit HeadlessViewer(const YarpViewOptions &opt, QObject *parent=nullptr);
+    ~HeadlessViewer() override;
+
+    // False if nothing could be opened (no port, no replay)
+    bool isRunning() const { return running; }
+
+private slots:
+    void onFrameAvailable();
+    void updateStatus();
+    void publishStats();
+
+private:
+    void pollFlightTrigger();
+    void logSummary();
+
+    YarpViewOptions options;
+    ImageReceiver receiver;
+    std::unique_ptr<FlightRecorder> flight;
+    std::unique_ptr<StreamRelay> relay;
+    yarp::os::BufferedPort<yarp::os::Bottle> statsPort;
+    yarp::os::BufferedPort<yarp::os::Bottle> flightPort;
+    QTimer *statusTimer{nullptr};
+    QTimer *statsTimer{nullptr};
+    LatencyStats latency;
+    int lastImgW{0};
+    int lastImgH{0};
+    int statusTicks{0};
+    bool running{false};
+    static constexpr int STATUS_PERIOD_MS = 250;
+    static constexpr int SUMMARY_TICKS = 40; // a console line every 10 s
+};
@@ -1,12 +1,26 @@
 #include "ImageReceiver.h"
+#include "FramePool.h"
+#include "PixelConvert.h"
+#include "Trace.h"
 #include <yarp/os/LogStream.h>
+#include <yarp/os/Network.h>
+#include <QBuffer>
 #include <QImage>
+#include <QImageReader>
 #include <QMetaObject>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
 
 #include <yarp/os/Time.h>
 
 ImageReceiver::ImageReceiver(QObject *parent) : QObject(parent) {
     port.owner = this;
+    encodedPort.owner = this;
+    decoder.setSink([this](FrameDecoder::Result &&r) { deliverDecoded(std::move(r)); });
 }
 
 ImageReceiver::~ImageReceiver() { 
@@ -14,39 +28,689 @@ ImageReceiver::~ImageReceiver() {
 }
 
 bool ImageReceiver::open(const std::string &portName, bool useCallback) {
-    if (!port.open(portName)) {
+    const bool ok = compressed ? encodedPort.open(portName) : port.open(portName);
+    if (!ok) {
         yError() << "Failed to open input port" << portName;
         return false;
     }
+    localPortName = compressed ? encodedPort.getName() : port.getName();
+    if (readPolicy != ReadPolicy::Latest) {
+        if (compressed) encodedPort.setStrict();
+        else port.setStrict();
+    }
     if (useCallback) {
-        port.useCallback();
+        if (compressed) encodedPort.useCallback();
+        else port.useCallback();
+    }
+    return true;
+}
+
+void ImageReceiver::setCompressedInput(bool on, int threads) {
+    compressed = on;
+    decoder.setThreads(threads);
+}
+
+const char *ImageReceiver::readPolicyName(ReadPolicy p) {
+    switch (p) {
+    case ReadPolicy::Strict: return "strict";
+    case ReadPolicy::Auto: return "auto";
+    default: return "latest";
+    }
+}
+
+bool ImageReceiver::readPolicyFromName(const char *name, ReadPolicy &p) {
+    for (ReadPolicy r : {ReadPolicy::Latest, ReadPolicy::Strict, ReadPolicy::Auto}) {
+        if (std::strcmp(name, readPolicyName(r)) == 0) { p = r; return true; }
+    }
+    return false;
+}
+
+void ImageReceiver::setReadPolicy(ReadPolicy p, int depth) {
+    readPolicy = p;
+    queueDepth = std::max(depth, 1);
+}
+
+ImageReceiver::QueueStats ImageReceiver::queueStats() const {
+    QueueStats s;
+    s.policy = readPolicy;
+    s.depth = queueDepth;
+    // getPendingReads() is const-incorrect in YARP but only reads the count
+    s.pending = compressed ? const_cast<EncodedPort&>(encodedPort).getPendingReads()
+                           : const_cast<ImagePort&>(port).getPendingReads();
+    s.maxPending = maxPendingReads.load(std::memory_order_relaxed);
+    s.skipped = queueSkipped.load(std::memory_order_relaxed);
+    s.flushes = queueFlushes.load(std::memory_order_relaxed);
+    s.portDropped = portDrops.load(std::memory_order_relaxed);
+    return s;
+}
+
+bool ImageReceiver::admitRead(int pending) {
+    // Called by onRead with the frames still queued behind this one
+    readPending = pending;
+    if (pending > maxPendingReads.load(std::memory_order_relaxed)) {
+        maxPendingReads.store(pending, std::memory_order_relaxed);
+    }
+    if (readPolicy == ReadPolicy::Latest) return true;
+    if (readPolicy == ReadPolicy::Auto) {
+        if (pending > queueDepth && !flushingBacklog) {
+            flushingBacklog = true;
+            queueFlushes.fetch_add(1, std::memory_order_relaxed);
+            Trace::instant("queueFlush");
+        }
+        // Skip until the newest frame is reached; it is shown
+        if (flushingBacklog && pending > 0) {
+            queueSkipped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        flushingBacklog = false;
+        return true;
+    }
+    if (pending > queueDepth) {
+        queueSkipped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void ImageReceiver::connectSource(const std::string &source, const std::string &carrier) {
+    if (source.empty() || localPortName.empty() || connectThread.joinable()) return;
+    connectSourceName = source;
+    connectCarrier = carrier.empty() ? std::string("auto") : carrier;
+    {
+        QMutexLocker lock(&connectionMutex);
+        connection.source = source;
+    }
+    connectStop = false;
+    connectThread = std::thread([this]() { connectLoop(); });
+}
+
+static void creditCarrier(ImageReceiver::ConnectionStats &s, quint64 bytes) {
+    if (s.carrier.empty()) return;
+    for (auto &c : s.carrierBytes) {
+        if (c.first == s.carrier) {
+            c.second += bytes;
+            return;
+        }
+    }
+    s.carrierBytes.emplace_back(s.carrier, bytes);
+}
+
+ImageReceiver::ConnectionStats ImageReceiver::connectionStats() const {
+    QMutexLocker lock(&connectionMutex);
+    ConnectionStats s = connection;
+    s.bytes = bytesIn.load(std::memory_order_relaxed);
+    // Credit what arrived since the last carrier change to the current one
+    creditCarrier(s, s.bytes - carrierBytesMark);
+    return s;
+}
+
+std::string ImageReceiver::chooseCarrier() const {
+    if (connectCarrier != "auto") return connectCarrier;
+    // Both contacts come from the name server, so the host strings compare
+    const yarp::os::Contact src = yarp::os::Network::queryName(connectSourceName);
+    const yarp::os::Contact local = yarp::os::Network::queryName(localPortName);
+    if (!src.isValid()) return std::string();
+    const std::string host = src.getHost();
+    const bool loopback = host == "localhost" || host.rfind("127.", 0) == 0;
+    return (loopback || host == local.getHost()) ? std::string("shmem") : std::string("tcp");
+}
+
+void ImageReceiver::connectLoop() {
+    std::unique_lock<std::mutex> lock(connectMutex);
+    bool everConnected = false;
+    bool warned = false;
+    while (!connectStop) {
+        lock.unlock();
+        // Name server round trips: kept off the reader and GUI threads
+        if (!yarp::os::Network::isConnected(connectSourceName, localPortName)) {
+            std::string carrier = chooseCarrier();
+            bool ok = !carrier.empty() && yarp::os::Network::connect(connectSourceName, localPortName, carrier);
+            if (!ok && (carrier == "shmem" || carrier == "fast_tcp")) {
+                yWarning() << "Cannot connect" << connectSourceName << "with" << carrier << "- falling back to tcp";
+                carrier = "tcp";
+                ok = yarp::os::Network::connect(connectSourceName, localPortName, carrier);
+            }
+            QMutexLocker stats(&connectionMutex);
+            const quint64 bytes = bytesIn.load(std::memory_order_relaxed);
+            creditCarrier(connection, bytes - carrierBytesMark);
+            carrierBytesMark = bytes;
+            connection.connected = ok;
+            connection.carrier = ok ? carrier : std::string();
+            if (ok) {
+                if (everConnected) connection.reconnects++;
+                yInfo() << (everConnected ? "Reconnected" : "Connected") << connectSourceName << "->" << localPortName << "via" << carrier;
+                everConnected = true;
+                warned = false;
+            } else if (!warned) {
+                yWarning() << "Waiting for" << connectSourceName << "to connect to" << localPortName;
+                warned = true;
+            }
+        }
+        lock.lock();
+        connectWake.wait_for(lock, std::chrono::seconds(1), [this]() { return connectStop; });
+    }
+}
+
+bool ImageReceiver::openReplay(const QString &path, double speed, bool loop) {
+    if (!replayReader.open(path)) return false;
+    if (replayReader.frameCount() == 0) {
+        yError() << path.toStdString() << "contains no frames";
+        replayReader.close();
+        return false;
     }
+    replaySpeed = std::max(0.0, speed);
+    replayLooping = loop;
+    replayStop = false;
+    replayIndex.store(0);
+    yInfo() << "Replaying" << replayReader.frameCount() << "frames from" << path.toStdString();
+    replayThread = std::thread([this]() { replayLoop(); });
     return true;
 }
 
 void ImageReceiver::close() {
+    if (connectThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(connectMutex);
+            connectStop = true;
+        }
+        connectWake.notify_all();
+        connectThread.join();
+    }
     port.close();
+    encodedPort.close();
+    decoder.waitForDone(); // its sink publishes into this object
+    if (replayThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(replayMutex);
+            replayStop = true;
+        }
+        replayWake.notify_all();
+        replayThread.join();
+        replayReader.close();
+    }
+    stopRecording();
+}
+
+bool ImageReceiver::startRecording(const QString &path) {
+    return recordWriter.open(path);
+}
+
+void ImageReceiver::stopRecording() {
+    recordWriter.close();
+}
+
+bool ImageReceiver::takeLatest(FrameMailbox::Frame &frame) {
+    // Clear before taking: a frame published after this point re-arms the
+    // notification, so nothing can be left behind unannounced.
+    notifyPending.store(false, std::memory_order_release);
+    return mailbox.take(frame);
+}
+
+void ImageReceiver::setJitterBuffer(double delayMs) {
+    jitter.setTargetDelay(delayMs);
+    jitter.clear();
+    jitterEnabled.store(delayMs > 0.0);
+}
+
+bool ImageReceiver::takeDue(FrameMailbox::Frame &frame, double &nextDue) {
+    notifyPending.store(false, std::memory_order_release);
+    return jitter.take(yarp::os::Time::now(), frame, nextDue);
+}
+
+bool ImageReceiver::flightFrame(int i, FrameMailbox::Frame &out) {
+    if (!flight) return false;
+    yarp::sig::FlexImage img;
+    QByteArray storage;
+    if (!flight->frame(i, img, out.stamp, storage)) return false;
+    QMutexLocker lock(&convertMutex);
+    if (!convertFrame(img, out.image)) return false;
+    out.fullSize = out.image.size();
+    out.readTime = out.publishTime = yarp::os::Time::now();
+    return true;
+}
+
+void ImageReceiver::setDepthSettings(const DepthColormap::Settings &s) {
+    QMutexLocker lock(&settingsMutex);
+    depthConfig = s;
+    depthRangeReset.store(true);
+}
+
+void ImageReceiver::setIngestSize(const QSize &size) {
+    QMutexLocker lock(&settingsMutex);
+    ingestSize = size;
+}
+
+DepthColormap::Settings ImageReceiver::depthSettings() const {
+    QMutexLocker lock(&settingsMutex);
+    return depthConfig;
+}
+
+void ImageReceiver::notify() {
+    if (notifyPending.exchange(true, std::memory_order_acq_rel)) return;
+    QMetaObject::invokeMethod(this, [this]() { emit frameAvailable(); }, Qt::QueuedConnection);
+}
+
+QString ImageReceiver::pixelCodeName(int code) {
+    // Vocabs are up to four ASCII characters packed little-endian
+    QString name;
+    for (int i=0; i<4; ++i) {
+        char c = char((code >> (8*i)) & 0xFF);
+        if (c) name += QChar(c);
+    }
+    return name.isEmpty() ? QString("-") : name;
+}
+
+void ImageReceiver::ImagePort::onRead(yarp::sig::FlexImage &img) {
+    if (!owner) return;
+    owner->bytesIn.fetch_add(img.getRawImageSize(), std::memory_order_relaxed);
+    owner->countArrival();
+    yarp::os::Stamp stamp;
+    getEnvelope(stamp);
+    if (!owner->admitRead(getPendingReads())) {
+        owner->countSequence(stamp); // our skip, not a transport loss
+        return;
+    }
+    if (owner->frozen.load()) {
+        // Discarded here, not lost on the way: keep the sequence baseline
+        owner->countSequence(stamp);
+        owner->frozenDrops.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Trace::nameThreadOnce("port reader");
+    Trace::Scope trace("onRead", stamp.getCount());
+    QElapsedTimer busy;
+    busy.start();
+    owner->processFrame(img, stamp);
+    owner->readBusyS = busy.nsecsElapsed() / 1e9;
 }
 
-void ImageReceiver::ImagePort::onRead(yarp::sig::ImageOf<yarp::sig::PixelBgra> &img) {
-    if (!owner || owner->frozen.load()) return;
+void ImageReceiver::replayLoop() {
+    using Clock = std::chrono::steady_clock;
+    if (Trace::enabled()) Trace::setThreadName("replay");
+    yarp::sig::FlexImage img;
+    yarp::os::Stamp stamp;
+    const size_t n = replayReader.frameCount();
+    size_t i = 0;
+    double prevStamp = replayReader.entry(0).stamp;
+    Clock::time_point due = Clock::now();
+    std::unique_lock<std::mutex> lock(replayMutex);
+    while (!replayStop) {
+        if (i == n) {
+            if (!replayLooping) break;
+            i = 0;
+        }
+        if (frozen.load()) {
+            replayWake.wait_for(lock, std::chrono::milliseconds(20));
+            due = Clock::now();
+            continue;
+        }
+        // Pace by the recorded stamp gaps; gaps over a second (pauses, stamp
+        // resets) are clamped and a late frame does not cause a burst
+        const double s = replayReader.entry(i).stamp;
+        if (replaySpeed > 0.0) {
+            const double gap = std::clamp(s - prevStamp, 0.0, 1.0) / replaySpeed;
+            due += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap));
+            const Clock::time_point now = Clock::now();
+            if (now - due > std::chrono::milliseconds(100)) due = now;
+            if (replayWake.wait_until(lock, due, [this]() { return replayStop; })) break;
+        }
+        prevStamp = s;
+        replayReader.prefetch(i+1);
+        lock.unlock();
+        if (replayReader.frame(i, img, stamp)) {
+            Trace::Scope trace("replayFrame", stamp.getCount());
+            countArrival();
+            processFrame(img, stamp);
+        }
+        lock.lock();
+        replayIndex.store(++i, std::memory_order_relaxed);
+    }
+    yInfo() << "Replay finished";
+}
 
+void ImageReceiver::EncodedPort::onRead(yarp::os::Bottle &b) {
+    if (!owner) return;
+    size_t bytes = 0;
+    for (size_t i=0; i<b.size(); ++i) {
+        if (b.get(i).isBlob()) bytes += b.get(i).asBlobLength();
+    }
+    owner->bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+    owner->countArrival();
     yarp::os::Stamp stamp;
     getEnvelope(stamp);
+    if (!owner->admitRead(getPendingReads())) {
+        owner->countSequence(stamp);
+        return;
+    }
+    if (owner->frozen.load()) {
+        // Discarded here, not lost on the way: keep the sequence baseline
+        owner->countSequence(stamp);
+        owner->frozenDrops.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Trace::nameThreadOnce("port reader");
+    Trace::Scope trace("onRead", stamp.getCount());
+    const double readTime = yarp::os::Time::now();
+    owner->countSequence(stamp);
+    for (size_t i=0; i<b.size(); ++i) {
+        const yarp::os::Value &v = b.get(i);
+        if (!v.isBlob()) continue;
+        if (!owner->conversion && !owner->relay) {
+            // Only the header is parsed, for the size and format
+            QByteArray header = QByteArray::fromRawData(v.asBlob(), qsizetype(v.asBlobLength()));
+            QBuffer buffer(&header);
+            buffer.open(QIODevice::ReadOnly);
+            QImageReader reader(&buffer);
+            FrameDecoder::Result r;
+            r.format = reader.format();
+            r.fullSize = reader.size();
+            r.stamp = stamp;
+            r.readTime = readTime;
+            owner->deliverDecoded(std::move(r));
+            return;
+        }
+        // The payload only lives until onRead returns: the decoder gets a copy
+        QByteArray data(v.asBlob(), qsizetype(v.asBlobLength()));
+        QSize target;
+        {
+            QMutexLocker lock(&owner->settingsMutex);
+            target = owner->ingestSize;
+        }
+        owner->decoder.submit(std::move(data), stamp, readTime, target);
+        return;
+    }
+    yWarning() << "Compressed input: message without a blob ignored";
+}
+
+void ImageReceiver::countArrival() {
+    QMutexLocker lock(&rateMutex);
+    arrivalRate.tick();
+}
+
+RateStats ImageReceiver::arrivalStats() const {
+    QMutexLocker lock(&rateMutex);
+    return arrivalRate;
+}
+
+void ImageReceiver::countSequence(const yarp::os::Stamp &stamp) {
+    if (!stamp.isValid()) return;
+    // In 64 bits: lastSeq + 1 must not overflow at the top of the int range.
+    // A wrap of the publisher's counter is a backward jump like a restart:
+    // the baseline is reset and nothing is counted.
+    const std::int64_t seq = stamp.getCount();
+    if (lastSeq >= 0 && seq > lastSeq + 1) {
+        const std::int64_t gap = seq - lastSeq - 1;
+        // With latest, the port overwrites frames we were too slow for: a
+        // newer one already waits, or the previous frame kept the reader
+        // busy longer than the publisher's frame interval. The rest of the
+        // gap never reached the port.
+        std::int64_t inPort = 0;
+        if (readPolicy == ReadPolicy::Latest) {
+            if (readPending > 0) {
+                inPort = gap;
+            } else if (readBusyS > 0.0 && lastStampTime >= 0.0) {
+                const double interval = (stamp.getTime() - lastStampTime) / double(gap + 1);
+                if (interval > 0.0) inPort = std::int64_t(std::min(readBusyS / interval, double(gap)));
+            }
+        }
+        portDrops.fetch_add(quint64(inPort), std::memory_order_relaxed);
+        transportDrops.fetch_add(quint64(gap - inPort), std::memory_order_relaxed);
+    }
+    lastSeq = seq;
+    lastStampTime = stamp.getTime();
+    readBusyS = 0.0;
+}
+
+FrameMailbox::Frame &ImageReceiver::producerSlot() {
+    const bool buffered = jitterEnabled.load(std::memory_order_relaxed);
+    return (matcher || buffered) ? stagingFrame : mailbox.back();
+}
+
+void ImageReceiver::publishSlot(FrameMailbox::Frame &slot) {
+    slot.publishTime = yarp::os::Time::now();
+    if (matcher) {
+        matcher->push(matcherPort, std::move(slot), slot.readTime);
+    } else if (&slot == &stagingFrame) {
+        jitter.push(std::move(slot), slot.readTime);
+    } else if (mailbox.publish()) {
+        Trace::instant("mailboxOverwrite", slot.stamp.getCount());
+    }
+    notify();
+}
+
+void ImageReceiver::deliverDecoded(FrameDecoder::Result &&r) {
+    // Called in order, one frame at a time, by the decoder
+    if (relay) relay->offer(r.image, r.fullSize, r.stamp, r.readTime);
+    FrameMailbox::Frame &slot = producerSlot();
+    slot.image = std::move(r.image);
+    slot.fullSize = r.fullSize;
+    slot.stamp = r.stamp;
+    slot.readTime = r.readTime;
+    const QByteArray fmt = r.format.left(4);
+    std::int32_t code = 0;
+    for (int i=0; i<fmt.size(); ++i) code |= std::int32_t(std::uint8_t(fmt[i])) << (8*i);
+    lastPixelCode.store(code, std::memory_order_relaxed); // shown as "jpeg", "png", ...
+    publishSlot(slot);
+}
+
+void ImageReceiver::processFrame(const yarp::sig::Image &img, const yarp::os::Stamp &stamp) {
+    if (img.width()==0 || img.height()==0) return;
+    const double readTime = yarp::os::Time::now();
+    countSequence(stamp);
+    // Native layout, ahead of any conversion, so the recording replays exactly;
+    // the reader only copies the rows, the file is written on its own thread
+    if (recordWriter.isOpen()) {
+        Trace::Scope trace("recordQueue", stamp.getCount());
+        recordWriter.append(img, stamp);
+    }
+
+    if (flight) flight->capture(img, stamp, readTime);
+    if (relay) relay->offer(img, stamp, readTime);
+
+    if (!conversion) {
+        FrameMailbox::Frame &slot = producerSlot();
+        slot.image = QImage();
+        slot.fullSize = QSize(int(img.width()), int(img.height()));
+        slot.stamp = stamp;
+        slot.readTime = readTime;
+        lastPixelCode.store(img.getPixelCode(), std::memory_order_relaxed);
+        publishSlot(slot);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    FrameMailbox::Frame &slot = producerSlot();
+    QSize target;
+    {
+        QMutexLocker lock(&settingsMutex);
+        target = ingestSize;
+    }
+    {
+        // The previous occupant of the slot returns to the pool once the GUI drops it.
+        Trace::Scope trace("convert", stamp.getCount());
+        QMutexLocker lock(&convertMutex);
+        if (!decimateFrame(img, target, slot.image)) {
+            if (!convertFrame(img, slot.image)) return;
+            reduceForIngest(slot.image, target);
+        }
+    }
+    slot.fullSize = QSize(int(img.width()), int(img.height()));
+    slot.stamp = stamp;
+    slot.readTime = readTime;
+    double ms = timer.nsecsElapsed() / 1e6;
+    double avg = convertMsAvg.load(std::memory_order_relaxed);
+    convertMsAvg.store(avg>0 ? 0.9*avg + 0.1*ms : ms, std::memory_order_relaxed);
+    lastPixelCode.store(img.getPixelCode(), std::memory_order_relaxed);
+    publishSlot(slot);
+}
 
-    // PixelBgra (BGRA bytes) matches QImage::Format_ARGB32 in-memory 
-    QImage qimg(img.getRawImage(),
-                img.width(),
-                img.height(),
-                img.getRowSize(),
-                QImage::Format_ARGB32);
-
-    //copies to avoid race condition with subsequent calls to onRead()
-    QImage safe=qimg.copy();
-
-    ImageReceiver* target = owner;
-    QMetaObject::invokeMethod(owner, [target, safe=std::move(safe), stamp]() {
-        //check for race condition with memory
-        if (target) emit target->imageArrived(safe, stamp); 
-    }, Qt::QueuedConnection);
+namespace {
+void copyRows(const unsigned char *src, size_t stride, QImage &dst, int rowBytes) {
+    for (int y=0; y<dst.height(); ++y) {
+        std::memcpy(dst.scanLine(y), src + y*stride, rowBytes);
+    }
+}
+}
+
+bool ImageReceiver::convertFrame(const yarp::sig::Image &img, QImage &out) {
+    const int w = int(img.width());
+    const int h = int(img.height());
+    const unsigned char *src = img.getRawImage();
+    const size_t stride = img.getRowSize();
+    FramePool &pool = FramePool::instance();
+
+    switch (img.getPixelCode()) {
+    // Codes QImage can show as they are: a plain row copy into a pooled buffer
+    case VOCAB_PIXEL_BGRA: // BGRA bytes == Format_(A)RGB32 in memory
+        out = pool.acquire(w, h, PixelConvert::alphaUnused(src, stride, w, h, 3) ? QImage::Format_RGB32 : QImage::Format_ARGB32);
+        copyRows(src, stride, out, w*4);
+        return true;
+    case VOCAB_PIXEL_RGBA:
+        out = pool.acquire(w, h, PixelConvert::alphaUnused(src, stride, w, h, 3) ? QImage::Format_RGBX8888 : QImage::Format_RGBA8888);
+        copyRows(src, stride, out, w*4);
+        return true;
+    case VOCAB_PIXEL_RGB:
+        out = pool.acquire(w, h, QImage::Format_RGB888);
+        copyRows(src, stride, out, w*3);
+        return true;
+    case VOCAB_PIXEL_BGR:
+        out = pool.acquire(w, h, QImage::Format_BGR888);
+        copyRows(src, stride, out, w*3);
+        return true;
+    case VOCAB_PIXEL_MONO:
+        out = pool.acquire(w, h, QImage::Format_Grayscale8);
+        copyRows(src, stride, out, w);
+        return true;
+    case VOCAB_PIXEL_MONO16:
+        if (convertDepth(img, out)) return true;
+        out = pool.acquire(w, h, QImage::Format_Grayscale16);
+        copyRows(src, stride, out, w*2);
+        return true;
+    // Float codes go through the SIMD kernels
+    case VOCAB_PIXEL_MONO_FLOAT:
+        if (convertDepth(img, out)) return true;
+        out = pool.acquire(w, h, QImage::Format_Grayscale8);
+        for (int y=0; y<h; ++y) {
+            PixelConvert::monoFloatToGray8(reinterpret_cast<const float*>(src + y*stride), out.scanLine(y), w);
+        }
+        return true;
+    case VOCAB_PIXEL_RGB_FLOAT:
+        out = pool.acquire(w, h, QImage::Format_RGB32);
+        for (int y=0; y<h; ++y) {
+            PixelConvert::rgbFloatToBgra(reinterpret_cast<const float*>(src + y*stride), out.scanLine(y), w);
+        }
+        return true;
+    default:
+        break;
+    }
+
+    // Rare codes (HSV, signed, int, ...): let YARP convert to BGRA
+    if (!genericScratch.copy(img)) {
+        yWarning() << "Unsupported pixel code" << pixelCodeName(img.getPixelCode()).toStdString();
+        return false;
+    }
+    out = pool.acquire(w, h, QImage::Format_ARGB32);
+    copyRows(genericScratch.getRawImage(), genericScratch.getRowSize(), out, w*4);
+    return true;
+}
+
+bool ImageReceiver::decimateFrame(const yarp::sig::Image &img, const QSize &target, QImage &out) {
+    if (target.isEmpty()) return false;
+    const int w = int(img.width());
+    const int h = int(img.height());
+    // Largest whole factor that keeps the frame at least as big as the target;
+    // the widget's scaler does the remaining fraction. Capped at what
+    // boxDecimate supports, so the buffer matches what it writes.
+    const int factor = std::min({w / target.width(), h / target.height(), PixelConvert::MAX_DECIMATE});
+    if (factor < 2) return false;
+    const unsigned char *src = img.getRawImage();
+    const size_t stride = img.getRowSize();
+    QImage::Format fmt;
+    int bpp;
+    switch (img.getPixelCode()) {
+    case VOCAB_PIXEL_BGRA:
+        fmt = PixelConvert::alphaUnused(src, stride, w, h, 3) ? QImage::Format_RGB32 : QImage::Format_ARGB32;
+        bpp = 4;
+        break;
+    case VOCAB_PIXEL_RGBA:
+        fmt = PixelConvert::alphaUnused(src, stride, w, h, 3) ? QImage::Format_RGBX8888 : QImage::Format_RGBA8888;
+        bpp = 4;
+        break;
+    case VOCAB_PIXEL_RGB: fmt = QImage::Format_RGB888; bpp = 3; break;
+    case VOCAB_PIXEL_BGR: fmt = QImage::Format_BGR888; bpp = 3; break;
+    case VOCAB_PIXEL_MONO: fmt = QImage::Format_Grayscale8; bpp = 1; break;
+    default: return false;
+    }
+    Trace::Scope trace("ingestDecimate");
+    out = FramePool::instance().acquire(w / factor, h / factor, fmt);
+    return PixelConvert::boxDecimate(src, stride, w, h, bpp, factor, out.bits(), size_t(out.bytesPerLine()));
+}
+
+void ImageReceiver::reduceForIngest(QImage &image, QSize target) {
+    if (target.isEmpty()) return;
+    target = target.boundedTo(image.size());
+    if (target.width() > image.width()*3/4 && target.height() > image.height()*3/4) return;
+    Trace::Scope trace("ingestScale");
+    // Same formats ImageScaler produces, so the pooled buffer is written in place.
+    // The pool keeps both the full-size and the reduced size idle, so neither
+    // is reallocated per frame; the full-size one goes back when image is replaced.
+    const QImage::Format fmt = image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    QImage reduced = ingestScaler.scale(image, target, ScaleKernels::Kernel::Area,
+                                        FramePool::instance().acquire(target.width(), target.height(), fmt));
+    if (!reduced.isNull()) image = std::move(reduced);
+}
+
+bool ImageReceiver::convertDepth(const yarp::sig::Image &img, QImage &out) {
+    DepthColormap::Settings cfg;
+    {
+        QMutexLocker lock(&settingsMutex);
+        cfg = depthConfig;
+    }
+    if (!cfg.enabled) return false;
+    if (!depthLutReady || cfg.map != depthLutMap) {
+        DepthColormap::buildLut(cfg.map, depthLut);
+        depthLutMap = cfg.map;
+        depthLutReady = true;
+    }
+    if (depthRangeReset.exchange(false)) autoRangeValid = false;
+
+    const int w = int(img.width());
+    const int h = int(img.height());
+    const unsigned char *src = img.getRawImage();
+    const size_t stride = img.getRowSize();
+    const bool isFloat = img.getPixelCode() == VOCAB_PIXEL_MONO_FLOAT;
+    out = FramePool::instance().acquire(w, h, QImage::Format_RGB32);
+
+    // Auto range maps with the running range of previous frames and folds this
+    // frame's min/max in afterwards, so a single pass suffices. The very first
+    // frame has no history and is mapped twice.
+    for (int pass=0; pass<2; ++pass) {
+        float lo = cfg.autoRange ? autoLo : cfg.nearValue;
+        float hi = cfg.autoRange ? autoHi : cfg.farValue;
+        if (!(hi > lo)) hi = lo + 1.0f;
+        const float scale = 255.0f / (hi - lo);
+        float mn = std::numeric_limits<float>::infinity();
+        float mx = 0.0f;
+        for (int y=0; y<h; ++y) {
+            auto *dst = reinterpret_cast<std::uint32_t*>(out.scanLine(y));
+            if (isFloat) {
+                DepthColormap::mapFloat(reinterpret_cast<const float*>(src + y*stride), dst, w, lo, scale, depthLut, mn, mx);
+            } else {
+                DepthColormap::mapMono16(reinterpret_cast<const std::uint16_t*>(src + y*stride), dst, w, lo, scale, depthLut, mn, mx);
+            }
+        }
+        depthLo.store(lo);
+        depthHi.store(hi);
+        if (!cfg.autoRange || !(mx >= mn)) break;
+        if (autoRangeValid) {
+            autoLo += 0.2f * (mn - autoLo);
+            autoHi += 0.2f * (mx - autoHi);
+            break;
+        }
+        autoLo = mn;
+        autoHi = mx;
+        autoRangeValid = true;
+    }
+    return true;
 }
@@ -3,9 +3,27 @@
 #include <QImage>
 #include <QMutex>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
 #include <yarp/sig/Image.h>
 #include <yarp/os/Stamp.h>
+#include "FrameMailbox.h"
+#include "DepthColormap.h"
+#include "FrameFile.h"
+#include "ImageScaler.h"
+#include "JitterBuffer.h"
+#include "StampMatcher.h"
+#include "FlightRecorder.h"
+#include "FrameDecoder.h"
+#include "StreamRelay.h"
+#include "RateStats.h"
 
 class ImageReceiver : public QObject {
     Q_OBJECT
@@ -14,21 +32,239 @@ public:
     ~ImageReceiver() override;
 
     bool open(const std::string &portName, bool useCallback=true);
+    // Compressed input: the port reads Bottles whose first blob is an encoded
+    // image (JPEG, PNG, ...), decoded by a pool of 'threads' instead of on the
+    // reader thread. Call before open(). Stream and flight recording only
+    // see raw frames and stay idle.
+    void setCompressedInput(bool on, int threads=3);
+    bool isCompressedInput() const { return compressed; }
+    FrameDecoder::Stats decodeStats() const { return decoder.stats(); }
+    // Off: nothing displays the frames (headless). They are still recorded,
+    // kept by the flight recorder and counted, but published without pixels:
+    // no conversion and no decoding, only the size and stamp go through.
+    void setConversion(bool on) { conversion = on; }
+
+    // Connects 'source' to the opened port, from a background thread that
+    // checks every second and reconnects when the link drops. carrier "auto"
+    // (or empty) picks shmem when the source runs on this host, tcp
+    // otherwise; a failing shmem/fast_tcp connection falls back to tcp.
+    void connectSource(const std::string &source, const std::string &carrier);
+    struct ConnectionStats {
+        std::string source;   // empty: no --connect
+        std::string carrier;  // of the current connection, empty while down
+        bool connected{false};
+        quint64 reconnects{0};
+        quint64 bytes{0};     // payload received, all carriers
+        std::vector<std::pair<std::string, quint64>> carrierBytes; // payload per carrier used
+    };
+    ConnectionStats connectionStats() const;
+
+    // What the port does when frames arrive faster than onRead handles them.
+    // Latest: YARP keeps only the newest unread frame (lowest latency).
+    // Strict: every frame is queued; beyond 'depth' waiting frames the
+    // oldest are skipped. Auto: strict, but a backlog beyond 'depth' is
+    // flushed at once so the display jumps back to the newest frame.
+    // Call before open().
+    enum class ReadPolicy { Latest, Strict, Auto };
+    static const char *readPolicyName(ReadPolicy p);
+    static bool readPolicyFromName(const char *name, ReadPolicy &p);
+    void setReadPolicy(ReadPolicy p, int depth);
+    struct QueueStats {
+        ReadPolicy policy{ReadPolicy::Latest};
+        int depth{0};
+        int pending{0};        // frames waiting in the port now
+        int maxPending{0};     // since open
+        quint64 skipped{0};    // taken off the queue unprocessed (strict/auto)
+        quint64 flushes{0};    // auto: backlogs dropped to catch up
+        quint64 portDropped{0}; // latest: overwritten in the port while we were behind (estimate)
+    };
+    QueueStats queueStats() const;
+    // Playback source instead of the port: frames of a FrameFile recording are
+    // fed to the same conversion path. speed scales the recorded stamp gaps
+    // (1 = original timing, 0 = as fast as possible). Freeze pauses playback.
+    bool openReplay(const QString &path, double speed=1.0, bool loop=false);
+    bool isReplaying() const { return replayThread.joinable(); }
+    quint64 replayPosition() const { return replayIndex.load(std::memory_order_relaxed); }
+    quint64 replayLength() const { return replayReader.frameCount(); }
     void close();
 
+    // Stream recording: every received frame is queued, before conversion,
+    // for a FrameFile written on its own thread.
+    bool startRecording(const QString &path);
+    void stopRecording();
+    bool isRecording() const { return recordWriter.isOpen(); }
+    FrameFile::QueuedWriter::Stats recordingStats() const { return recordWriter.stats(); }
+
     void setFrozen(bool f) { frozen.store(f); }
     bool isFrozen() const { return frozen.load(); }
 
+    // GUI side: fetch the newest frame, if any arrived since the last call.
+    // Re-arms the wake-up notification.
+    bool takeLatest(FrameMailbox::Frame &frame);
+    quint64 framesReceived() const { return mailbox.published(); }
+    // Arrival rate, ticked on the reader thread for every frame read (also
+    // those skipped, overwritten in the mailbox or frozen); a snapshot
+    RateStats arrivalStats() const;
+    // Frames discarded inside the viewer: overwritten in the mailbox before
+    // the GUI took them, or received while frozen
+    quint64 framesDropped() const { return mailbox.dropped() + frozenDrops.load(std::memory_order_relaxed); }
+    // Frames the publisher sent but never reached us: gaps in the envelope
+    // sequence numbers (a backward jump is taken as a publisher restart),
+    // less those queueStats() counts as overwritten in the port
+    quint64 transportDropped() const { return transportDrops.load(std::memory_order_relaxed); }
+
+    // Jitter buffer: with a delay > 0 frames are held in stamp order and
+    // released by takeDue() at publisher-relative times plus the delay,
+    // instead of going through the latest-only mailbox. 0 turns it off.
+    void setJitterBuffer(double delayMs);
+    bool jitterBufferEnabled() const { return jitterEnabled.load(); }
+    // nextDue: local yarp::os::Time of the next buffered frame, 0 if none
+    bool takeDue(FrameMailbox::Frame &frame, double &nextDue);
+    JitterBuffer::Stats jitterStats() const { return jitter.stats(); }
+
+    // Stamp matching: frames go to port 'port' of the matcher instead of the
+    // mailbox or jitter buffer; frameAvailable still fires per frame. Call
+    // before open(); the matcher must outlive the receiver's port.
+    void setMatcher(StampMatcher *m, int port) { matcher = m; matcherPort = port; }
+    // Re-arms frameAvailable when frames are taken from the matcher
+    void acknowledge() { notifyPending.store(false, std::memory_order_release); }
+
+    // Flight recorder: every received frame is also kept, native, in its
+    // pre-roll ring. Call before open(); the recorder must outlive the port.
+    void setFlightRecorder(FlightRecorder *f) { flight = f; }
+    // Re-publish output fed from the reader thread (decoded frames for
+    // compressed input); the relay must outlive the open port
+    void setRelay(StreamRelay *r) { relay = r; }
+    // GUI side: frame i of the flight recorder ring converted for display at
+    // full resolution (for stepping through it while frozen)
+    bool flightFrame(int i, FrameMailbox::Frame &out);
+
+    // Conversion cost (smoothed, ms per frame) and pixel code of the last frame
+    double convertMs() const { return convertMsAvg.load(std::memory_order_relaxed); }
+    int pixelCode() const { return lastPixelCode.load(std::memory_order_relaxed); }
+    static QString pixelCodeName(int code);
+
+    // Reduce frames to about this size on the reader thread when it saves at
+    // least a quarter per axis; an invalid size keeps full resolution.
+    // 8-bit codes are area-averaged straight out of the port buffer by an
+    // integer factor, so the full-resolution frame is never copied; other
+    // codes are converted first and then resampled. Frame::fullSize carries
+    // the stream resolution either way.
+    void setIngestSize(const QSize &size);
+
+    // Colormap rendering of mono16 / float images (applied on the reader thread)
+    void setDepthSettings(const DepthColormap::Settings &s);
+    DepthColormap::Settings depthSettings() const;
+    // Range used for the last colormapped frame (native units)
+    void depthRange(double &lo, double &hi) const { lo = depthLo.load(); hi = depthHi.load(); }
+
 signals:
-    void imageArrived(const QImage &img, const yarp::os::Stamp &stamp);
+    // Emitted (queued) when a new frame is waiting in the mailbox. At most one
+    // notification is pending at any time, regardless of the port rate.
+    void frameAvailable();
 
 private:
-    class ImagePort : public yarp::os::BufferedPort<yarp::sig::ImageOf<yarp::sig::PixelBgra>> {
+    // Accepts any pixel code; conversion happens in convertFrame()
+    class ImagePort : public yarp::os::BufferedPort<yarp::sig::FlexImage> {
+    public:
+        ImageReceiver *owner{nullptr};
+        void onRead(yarp::sig::FlexImage &img) override;
+    };
+
+    class EncodedPort : public yarp::os::BufferedPort<yarp::os::Bottle> {
     public:
         ImageReceiver *owner{nullptr};
-        void onRead(yarp::sig::ImageOf<yarp::sig::PixelBgra> &img) override;
+        void onRead(yarp::os::Bottle &b) override;
     };
 
+    void processFrame(const yarp::sig::Image &img, const yarp::os::Stamp &stamp);
+    bool admitRead(int pending);
+    void connectLoop();
+    std::string chooseCarrier() const;
+    void countSequence(const yarp::os::Stamp &stamp);
+    void countArrival();
+    // Producer side shared by processFrame() and decoded frames: fill the
+    // slot, then publish it to the matcher, jitter buffer or mailbox
+    FrameMailbox::Frame &producerSlot();
+    void publishSlot(FrameMailbox::Frame &slot);
+    void deliverDecoded(FrameDecoder::Result &&r);
+    bool convertFrame(const yarp::sig::Image &img, QImage &out);
+    bool convertDepth(const yarp::sig::Image &img, QImage &out);
+    bool decimateFrame(const yarp::sig::Image &img, const QSize &target, QImage &out);
+    void reduceForIngest(QImage &image, QSize target);
+    void notify();
+    void replayLoop();
+
     ImagePort port;
+    EncodedPort encodedPort;
+    bool compressed{false};
+    bool conversion{true};
+    FrameDecoder decoder;
+    FrameMailbox mailbox;
+    std::atomic<bool> notifyPending{false};
     std::atomic<bool> frozen{false};
+    std::atomic<quint64> frozenDrops{0};
+    std::atomic<double> convertMsAvg{0.0};
+    std::atomic<int> lastPixelCode{0};
+    std::atomic<quint64> transportDrops{0};
+    std::atomic<quint64> portDrops{0};
+    mutable QMutex rateMutex;
+    RateStats arrivalRate; // guarded by rateMutex
+    std::int64_t lastSeq{-1}; // reader thread only
+    double lastStampTime{-1.0};
+    int readPending{0};      // frames waiting behind the one being read
+    double readBusyS{0.0};   // last processFrame() time, taken by the next countSequence()
+    JitterBuffer jitter;
+    std::atomic<bool> jitterEnabled{false};
+    StampMatcher *matcher{nullptr};
+    FlightRecorder *flight{nullptr};
+    StreamRelay *relay{nullptr};
+    QMutex convertMutex; // conversion state below: reader thread vs flightFrame()
+    int matcherPort{0};
+    FrameMailbox::Frame stagingFrame; // producer only: frames bypassing the mailbox
+    yarp::sig::ImageOf<yarp::sig::PixelBgra> genericScratch; // reader thread only
+    ImageScaler ingestScaler; // reader thread only
+
+    FrameFile::QueuedWriter recordWriter;
+
+    FrameFile::Reader replayReader;
+    std::thread replayThread;
+    std::mutex replayMutex;
+    std::condition_variable replayWake;
+    bool replayStop{false}; // guarded by replayMutex
+    double replaySpeed{1.0};
+    bool replayLooping{false};
+    std::atomic<quint64> replayIndex{0};
+
+    ReadPolicy readPolicy{ReadPolicy::Latest};
+    int queueDepth{8};
+    bool flushingBacklog{false};         // reader thread only
+    std::atomic<int> maxPendingReads{0};
+    std::atomic<quint64> queueSkipped{0};
+    std::atomic<quint64> queueFlushes{0};
+    std::atomic<quint64> bytesIn{0};
+    std::thread connectThread;
+    std::mutex connectMutex;
+    std::condition_variable connectWake;
+    bool connectStop{false}; // guarded by connectMutex
+    std::string localPortName;
+    std::string connectSourceName;
+    std::string connectCarrier;          // requested: "auto" or a carrier name
+    mutable QMutex connectionMutex;
+    ConnectionStats connection;          // guarded by connectionMutex
+    quint64 carrierBytesMark{0};         // bytesIn when the current carrier started
+
+    mutable QMutex settingsMutex;
+    DepthColormap::Settings depthConfig;  // guarded by settingsMutex
+    QSize ingestSize;                     // guarded by settingsMutex
+    std::atomic<bool> depthRangeReset{true};
+    std::atomic<float> depthLo{0.0f};
+    std::atomic<float> depthHi{0.0f};
+    // reader thread only
+    std::uint32_t depthLut[256];
+    DepthColormap::Map depthLutMap{DepthColormap::Map::Gray};
+    bool depthLutReady{false};
+    bool autoRangeValid{false};
+    float autoLo{0.0f};
+    float autoHi{0.0f};
 };
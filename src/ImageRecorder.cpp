@@ -0,0 +1,152 @@
+#include "ImageRecorder.h"
+#include "Trace.h"
+#include <QMutexLocker>
+#include <QTextStream>
+#include <yarp/os/LogStream.h>
+#include <algorithm>
+
+ImageRecorder::~ImageRecorder() {
+    stop();
+    joinWorkers();
+}
+
+const char *ImageRecorder::formatName(Format f) {
+    switch (f) {
+    case Format::Png: return "png";
+    case Format::Jpeg: return "jpg";
+    case Format::Ppm: return "ppm";
+    case Format::Raw: return "raw";
+    }
+    return "png";
+}
+
+bool ImageRecorder::formatFromName(const QString &name, Format &f) {
+    const QString n = name.toLower();
+    if (n=="jpeg") { f = Format::Jpeg; return true; }
+    for (Format c : {Format::Png, Format::Jpeg, Format::Ppm, Format::Raw}) {
+        if (n==formatName(c)) { f = c; return true; }
+    }
+    return false;
+}
+
+bool ImageRecorder::start(const QString &dir, const Settings &s) {
+    stop();
+    joinWorkers(); // a previous session may still be draining
+    indexFile.setFileName(dir + "/index.txt");
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        yError() << "Cannot create" << indexFile.fileName().toStdString();
+        return false;
+    }
+    indexFile.write("# frame file seq stamp width height qimage_format\n");
+    {
+        QMutexLocker lock(&mutex);
+        settings = s;
+        settings.threads = std::max(1, s.threads);
+        settings.queueDepth = std::max(1, s.queueDepth);
+        directory = dir;
+        nextIndex = 0;
+        counters = Stats();
+        accepting = true;
+        stopping = false;
+    }
+    for (int i=0; i<settings.threads; ++i) workers.emplace_back([this]() { workerLoop(); });
+    return true;
+}
+
+void ImageRecorder::stop() {
+    QMutexLocker lock(&mutex);
+    accepting = false;
+    stopping = true;
+    notEmpty.wakeAll();
+}
+
+void ImageRecorder::joinWorkers() {
+    for (auto &t : workers) t.join();
+    workers.clear();
+    QMutexLocker lock(&indexMutex);
+    if (indexFile.isOpen()) indexFile.close();
+}
+
+bool ImageRecorder::isRecording() const {
+    QMutexLocker lock(&mutex);
+    return accepting;
+}
+
+bool ImageRecorder::push(const QImage &img, const yarp::os::Stamp &stamp) {
+    QMutexLocker lock(&mutex);
+    if (!accepting) return false;
+    if ((int)queue.size() >= settings.queueDepth) {
+        counters.dropped++;
+        return false;
+    }
+    // Shares the pixels: no copy on the GUI thread
+    queue.push_back(Job{img, stamp, nextIndex++});
+    notEmpty.wakeOne();
+    return true;
+}
+
+ImageRecorder::Stats ImageRecorder::stats() const {
+    QMutexLocker lock(&mutex);
+    Stats s = counters;
+    s.queued = queue.size();
+    return s;
+}
+
+void ImageRecorder::workerLoop() {
+    if (Trace::enabled()) Trace::setThreadName("image set encoder");
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker lock(&mutex);
+            while (queue.empty() && !stopping) notEmpty.wait(&mutex);
+            if (queue.empty()) return; // stopping and drained
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        QString fileName;
+        bool ok;
+        {
+            Trace::Scope trace("encode", job.stamp.getCount());
+            ok = writeFrame(job, fileName);
+        }
+        {
+            QMutexLocker lock(&mutex);
+            if (ok) counters.written++; else counters.failed++;
+        }
+        if (!ok) continue;
+        // Lines are appended in completion order; the frame column gives the sequence
+        QMutexLocker lock(&indexMutex);
+        QTextStream ts(&indexFile);
+        ts << job.index << ' ' << fileName << ' ' << job.stamp.getCount() << ' '
+           << QString::number(job.stamp.getTime(), 'f', 6) << ' '
+           << job.image.width() << ' ' << job.image.height() << ' ' << int(job.image.format()) << '\n';
+    }
+}
+
+bool ImageRecorder::writeFrame(const Job &job, QString &fileName) {
+    fileName = QString("image_%1.%2").arg(job.index, 6, 10, QChar('0')).arg(formatName(settings.format));
+    const QString path = directory + "/" + fileName;
+    switch (settings.format) {
+    case Format::Png: {
+        // Qt maps PNG quality q to zlib level (100-q)*9/91; invert that for a level 0-9
+        int q = -1;
+        if (settings.quality >= 0) q = 100 - (std::min(settings.quality, 9)*91 + 8)/9;
+        return job.image.save(path, "PNG", q);
+    }
+    case Format::Jpeg:
+        return job.image.save(path, "JPG", settings.quality);
+    case Format::Ppm:
+        return job.image.save(path, "PPM");
+    case Format::Raw: {
+        // Tightly packed rows in the QImage format listed in the index
+        QFile f(path);
+        if (!f.open(QIODevice::WriteOnly)) return false;
+        const qint64 rowBytes = (qint64(job.image.width()) * job.image.depth() + 7) / 8;
+        for (int y=0; y<job.image.height(); ++y) {
+            if (f.write(reinterpret_cast<const char*>(job.image.constScanLine(y)), rowBytes) != rowBytes) return false;
+        }
+        return true;
+    }
+    }
+    return false;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFile>
+#include <QString>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <yarp/os/Stamp.h>
+
+// Background writer for "Save a set of images": frames are queued (bounded,
+// newest dropped when full) and encoded by a small pool of threads. Each
+// written frame gets a line in <dir>/index.txt with its envelope stamp.
+class ImageRecorder {
+public:
+    enum class Format { Png, Jpeg, Ppm, Raw };
+
+    struct Settings {
+        Format format = Format::Png;
+        int quality = -1;    // PNG: compression level 0-9, JPEG: quality 0-100, -1: codec default
+        int threads = 2;
+        int queueDepth = 16; // frames waiting for an encoder
+    };
+
+    struct Stats {
+        quint64 queued{0};  // currently waiting
+        quint64 written{0};
+        quint64 dropped{0}; // queue full
+        quint64 failed{0};  // encoder/IO errors
+    };
+
+    ImageRecorder() = default;
+    ~ImageRecorder();
+
+    bool start(const QString &dir, const Settings &s);
+    // Stops accepting frames; already queued frames are still written.
+    void stop();
+    bool isRecording() const;
+    // Returns false if the frame was dropped.
+    bool push(const QImage &img, const yarp::os::Stamp &stamp);
+    Stats stats() const;
+
+    static const char *formatName(Format f);
+    static bool formatFromName(const QString &name, Format &f);
+
+private:
+    struct Job {
+        QImage image;
+        yarp::os::Stamp stamp;
+        quint64 index{0};
+    };
+
+    void workerLoop();
+    bool writeFrame(const Job &job, QString &fileName);
+    void joinWorkers();
+
+    mutable QMutex mutex;
+    QWaitCondition notEmpty;
+    std::deque<Job> queue;
+    std::vector<std::thread> workers;
+    bool accepting{false};
+    bool stopping{false};
+    Settings settings;
+    QString directory;
+    quint64 nextIndex{0};
+    Stats counters;
+
+    QMutex indexMutex;
+    QFile indexFile;
+};
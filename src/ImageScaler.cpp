@@ -0,0 +1,47 @@
+#include "ImageScaler.h"
+#include "Trace.h"
+#include <QSemaphore>
+#include <algorithm>
+
+QThreadPool *ImageScaler::slicePool() {
+    static QThreadPool pool;
+    return &pool;
+}
+
+QImage ImageScaler::scale(const QImage &srcIn, const QSize &size, ScaleKernels::Kernel kernel, QImage &&reuse) {
+    if (srcIn.isNull() || size.isEmpty()) return QImage();
+    const QImage::Format fast = srcIn.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    const QImage src = srcIn.format()==fast ? srcIn : srcIn.convertToFormat(fast);
+    if (src.size()==size) return src;
+
+    QImage out = std::move(reuse);
+    if (out.size()!=size || out.format()!=fast || !out.isDetached()) out = QImage(size, fast);
+    if (!plan.matches(src.width(), src.height(), size.width(), size.height(), kernel)) {
+        plan = ScaleKernels::Plan(src.width(), src.height(), size.width(), size.height(), kernel);
+    }
+
+    const uchar *s = src.constBits();
+    const size_t sStride = size_t(src.bytesPerLine());
+    uchar *d = out.bits();
+    const size_t dStride = size_t(out.bytesPerLine());
+    const int h = size.height();
+    // At least 32 rows per slice; the calling thread takes the first slice itself
+    const int slices = std::clamp(h / 32, 1, slicePool()->maxThreadCount() + 1);
+    QSemaphore done;
+    for (int i=1; i<slices; ++i) {
+        const int y0 = h * i / slices;
+        const int y1 = h * (i+1) / slices;
+        slicePool()->start([this, s, sStride, d, dStride, y0, y1, &done]() {
+            Trace::nameThreadOnce("scale slice");
+            Trace::Scope trace("scaleSlice");
+            plan.run(s, sStride, d, dStride, y0, y1);
+            done.release();
+        });
+    }
+    {
+        Trace::Scope trace("scaleSlice");
+        plan.run(s, sStride, d, dStride, 0, h / slices);
+    }
+    done.acquire(slices - 1);
+    return out;
+}
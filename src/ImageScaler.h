@@ -0,0 +1,23 @@
+#pragma once
+#include <QImage>
+#include <QSize>
+#include <QThreadPool>
+#include "ScaleKernels.h"
+
+// Scales images with ScaleKernels, splitting the output rows across a shared
+// worker pool. One ImageScaler must only be used by one thread at a time (it
+// caches the tables for the last geometry); the slice pool is process wide.
+class ImageScaler {
+public:
+    ImageScaler() = default;
+
+    // Returns src converted to RGB32 (or ARGB32_Premultiplied if it has alpha)
+    // and resampled to size. 'reuse' donates a buffer for the result when it
+    // has the right size/format and is not shared.
+    QImage scale(const QImage &src, const QSize &size, ScaleKernels::Kernel kernel, QImage &&reuse = QImage());
+
+    static QThreadPool *slicePool();
+
+private:
+    ScaleKernels::Plan plan;
+};
@@ -1,49 +1,144 @@
 #include "ImageWidget.h"
+#include "Trace.h"
 #include <QPainter>
+#include <QElapsedTimer>
 #include <QMouseEvent>
+#include <QTransform>
+#include <QMetaObject>
+#include <QResizeEvent>
+#include <QThread>
+#include <QTimer>
 #include <algorithm>
+#include <cmath>
 
 ImageWidget::ImageWidget(QWidget *parent) : QWidget(parent) {
-    dispTimer.start();
     setMouseTracking(true);
 }
 
+ImageWidget::~ImageWidget() {
+    // The render job uses this object's scaler and pyramid: let it finish first
+    renderIdle.acquire();
+}
+
+QThreadPool *ImageWidget::renderPool() {
+    // One job per widget at a time (scaleBusy); a mosaic shares a few threads
+    // instead of owning one each. The row slices run on ImageScaler's pool.
+    static QThreadPool *pool = []() {
+        auto *p = new QThreadPool;
+        p->setMaxThreadCount(std::max(1, QThread::idealThreadCount()/2));
+        return p;
+    }();
+    return pool;
+}
+
 void ImageWidget::setAutoResize(bool on) { autoResize = on; }
 
-void ImageWidget::setSourceImage(const QImage &img) {
+void ImageWidget::setSourceImage(const QImage &img, const QSize &full) {
     if (img.isNull()) return;
+    // A frame reduced at ingest keeps zoom and pan: only the stream geometry counts
+    const QSize streamSize = full.isValid() ? full : img.size();
+    const bool newGeometry = streamSize!=fullSize;
     source = img;
+    fullSize = streamSize;
+    if (newGeometry) {
+        zoom = 1.0;
+        pan = QPointF(fullSize.width()/2.0, fullSize.height()/2.0);
+        notifyIngestSize();
+    }
     if (mode==DisplayMode::OriginalSize && autoResize) {
-        resize(source.size());
+        resize(fullSize);
     }
-    update();
+    // The repaint is triggered when the scaled frame is ready
+    requestRender();
+}
+
+void ImageWidget::setScaleKernel(ScaleKernels::Kernel k) {
+    scaleKernel = k;
+    requestRender();
 }
 
 void ImageWidget::setMode(DisplayMode m) {
     mode = m;
     update();
+    notifyIngestSize();
 }
 
-void ImageWidget::resetZoom() { update(); }
+void ImageWidget::resetZoom() {
+    zoom = 1.0;
+    pan = QPointF(fullSize.width()/2.0, fullSize.height()/2.0);
+    requestRender();
+    update();
+    notifyIngestSize();
+}
 
-void ImageWidget::paintEvent(QPaintEvent *) {
-    if (source.isNull()) return;
-    double dispMs = dispTimer.restart();
-    if (dispMs>0) {
-        dispIntervals.push_back(dispMs);
-        if ((int)dispIntervals.size()>FPS_WINDOW) dispIntervals.pop_front();
-    }
+void ImageWidget::setCaption(const QString &text) {
+    if (text == caption) return;
+    caption = text;
+    update();
+}
+
+QSize ImageWidget::ingestSizeHint() const {
+    // Original size and magnified views need every source pixel
+    if (fullSize.isEmpty() || mode==DisplayMode::OriginalSize || zoom > 1.0) return QSize();
+    return deviceSizeFor(computeDrawRect()).boundedTo(fullSize);
+}
+
+void ImageWidget::notifyIngestSize() {
+    const QSize hint = ingestSizeHint();
+    if (hint == lastIngestHint) return;
+    lastIngestHint = hint;
+    emit ingestSizeHintChanged();
+}
+
+void ImageWidget::setColorbar(const QImage &strip, double lo, double hi) {
+    // No update() here: the legend follows the next frame's repaint
+    colorbar = strip;
+    colorbarLo = lo;
+    colorbarHi = hi;
+}
+
+void ImageWidget::drawColorbar(QPainter &p) {
+    if (colorbar.isNull()) return;
+    const int barW = 12;
+    const int barH = std::min(160, height()/2);
+    if (barH < 32) return;
+    QRect bar(width()-barW-8, height()-barH-8, barW, barH);
+    // LUT runs low->high left to right; draw it bottom (near) to top (far)
+    QTransform t;
+    t.rotate(-90);
+    p.drawImage(bar, colorbar.transformed(t));
+    p.setPen(Qt::white);
+    p.drawRect(bar.adjusted(0,0,-1,-1));
+    QFontMetrics fm = p.fontMetrics();
+    QString hi = QString::number(colorbarHi, 'g', 4);
+    QString lo = QString::number(colorbarLo, 'g', 4);
+    p.drawText(bar.left()-fm.horizontalAdvance(hi)-4, bar.top()+fm.ascent(), hi);
+    p.drawText(bar.left()-fm.horizontalAdvance(lo)-4, bar.bottom(), lo);
+}
+
+void ImageWidget::drawCaption(QPainter &p) {
+    if (caption.isEmpty()) return;
+    const QFontMetrics fm = p.fontMetrics();
+    const QRect text = fm.boundingRect(QRect(0, 0, width(), height()), Qt::AlignLeft | Qt::AlignTop, caption);
+    const QRect box = text.translated(4, 4).adjusted(-3, -2, 3, 2);
+    p.fillRect(box, QColor(0, 0, 0, 160));
+    p.setPen(Qt::white);
+    p.drawText(box.adjusted(3, 2, -3, -2), Qt::AlignLeft | Qt::AlignTop, caption);
+}
+
+QRect ImageWidget::computeDrawRect() const {
     QSize avail = size();
     QSize drawSize;
     QPoint topLeft(0,0);
+    // Placement follows the stream resolution, not the (possibly reduced) frame
     if (mode==DisplayMode::OriginalSize) {
-        drawSize = source.size();
+        drawSize = fullSize;
         // center if window bigger
         if (avail.width() > drawSize.width()) topLeft.setX((avail.width()-drawSize.width())/2);
         if (avail.height() > drawSize.height()) topLeft.setY((avail.height()-drawSize.height())/2);
     } else if (mode==DisplayMode::AspectRatio) {
-        if (source.width()>0 && source.height()>0) {
-            double aspect = double(source.height())/double(source.width());
+        if (fullSize.width()>0 && fullSize.height()>0) {
+            double aspect = double(fullSize.height())/double(fullSize.width());
             int w = avail.width();
             int h = int(std::round(w * aspect));
             if (h > avail.height()) {
@@ -54,66 +149,325 @@ void ImageWidget::paintEvent(QPaintEvent *) {
             if (w < avail.width()) topLeft.setX((avail.width()-w)/2);
             if (h < avail.height()) topLeft.setY((avail.height()-h)/2);
         } else {
-            drawSize = source.size();
+            drawSize = fullSize;
         }
     } else { // StretchToWindow (fill entire widget, no letterbox)
         drawSize = avail;
     }
-    lastDrawRect_ = QRect(topLeft, drawSize);
+    return QRect(topLeft, drawSize);
+}
+
+ImageWidget::View ImageWidget::computeView() const {
+    View v;
+    if (source.isNull()) return v;
+    const QRect base = computeDrawRect();
+    const double sw = source.width(), sh = source.height();
+    v.fullScaleX = base.width() / double(fullSize.width()) * zoom;
+    v.fullScaleY = base.height() / double(fullSize.height()) * zoom;
+    v.scaleX = v.fullScaleX * fullSize.width() / sw;
+    v.scaleY = v.fullScaleY * fullSize.height() / sh;
+    if (v.scaleX <= 0.0 || v.scaleY <= 0.0) return v;
+    v.origin = QPointF(base.x() + base.width()/2.0 - pan.x()*v.fullScaleX,
+                       base.y() + base.height()/2.0 - pan.y()*v.fullScaleY);
+    v.image = QRectF(v.origin, QSizeF(sw*v.scaleX, sh*v.scaleY));
+    const QRectF vis = v.image.intersected(QRectF(rect()));
+    if (vis.isEmpty()) return v;
+    // Whole source pixels touching the visible area
+    const int x0 = std::clamp(int(std::floor((vis.left()-v.origin.x())/v.scaleX)), 0, int(sw)-1);
+    const int y0 = std::clamp(int(std::floor((vis.top()-v.origin.y())/v.scaleY)), 0, int(sh)-1);
+    const int x1 = std::clamp(int(std::ceil((vis.right()-v.origin.x())/v.scaleX)), x0+1, int(sw));
+    const int y1 = std::clamp(int(std::ceil((vis.bottom()-v.origin.y())/v.scaleY)), y0+1, int(sh));
+    v.roi = QRect(x0, y0, x1-x0, y1-y0);
+    const qreal dpr = devicePixelRatioF();
+    const int tx0 = qRound((v.origin.x() + x0*v.scaleX)*dpr), tx1 = qRound((v.origin.x() + x1*v.scaleX)*dpr);
+    const int ty0 = qRound((v.origin.y() + y0*v.scaleY)*dpr), ty1 = qRound((v.origin.y() + y1*v.scaleY)*dpr);
+    v.target = QRect(tx0, ty0, std::max(tx1-tx0, 1), std::max(ty1-ty0, 1));
+    // Filtering kernels resample from the pyramid level closest above the
+    // output resolution; nearest samples level 0 directly (cost ~ output size)
+    if (scaleKernel != ScaleKernels::Kernel::Nearest) {
+        double s = std::min(v.scaleX, v.scaleY) * dpr;
+        while (s*2.0 <= 1.0 && (source.width() >> (v.mipLevel+1)) >= 1 && (source.height() >> (v.mipLevel+1)) >= 1) {
+            s *= 2.0;
+            v.mipLevel++;
+        }
+    }
+    return v;
+}
+
+void ImageWidget::clampPan() {
+    pan.setX(std::clamp(pan.x(), 0.0, double(fullSize.width())));
+    pan.setY(std::clamp(pan.y(), 0.0, double(fullSize.height())));
+}
+
+void ImageWidget::zoomAt(const QPointF &wpt, double factor) {
+    const View before = computeView();
+    if (before.scaleX <= 0.0) return;
+    // Keep the image point under the cursor fixed
+    const QPointF p((wpt.x()-before.origin.x())/before.fullScaleX, (wpt.y()-before.origin.y())/before.fullScaleY);
+    zoom = std::clamp(zoom*factor, MIN_ZOOM, MAX_ZOOM);
+    const QRect base = computeDrawRect();
+    const double sx = base.width() / double(fullSize.width()) * zoom;
+    const double sy = base.height() / double(fullSize.height()) * zoom;
+    pan = QPointF((base.x() + base.width()/2.0 - (wpt.x() - p.x()*sx)) / sx,
+                  (base.y() + base.height()/2.0 - (wpt.y() - p.y()*sy)) / sy);
+    clampPan();
+    requestRender();
+    update();
+    notifyIngestSize();
+}
+
+QSize ImageWidget::deviceSizeFor(const QRect &r) const {
+    const qreal dpr = devicePixelRatioF();
+    return QSize(qRound(r.width()*dpr), qRound(r.height()*dpr));
+}
+
+bool ImageWidget::renderMatches(const QImage &img, const RenderRequest &req, const View &v) const {
+    return !img.isNull() && req.key==source.cacheKey() && req.roi==v.roi
+        && req.outSize==v.target.size() && req.kernel==scaleKernel && req.mipLevel==v.mipLevel;
+}
+
+void ImageWidget::installRender(QImage &&out, const RenderRequest &req) {
+    spare = std::move(cache);
+    cache = std::move(out);
+    cacheReq = req;
+    update();
+}
+
+void ImageWidget::setPresentOnRequest(bool on) {
+    presentOnRequest = on;
+    if (!on) presentRendered();
+}
+
+bool ImageWidget::presentRendered() {
+    if (ready.isNull()) return false;
+    installRender(std::move(ready), readyReq);
+    ready = QImage();
+    return true;
+}
+
+void ImageWidget::requestRender() {
+    if (source.isNull()) return;
+    const View v = computeView();
+    if (v.roi.isEmpty() || cacheMatches(v) || renderMatches(ready, readyReq, v)) return;
+    if (scaleBusy) { scaleAgain = true; return; }
+    // The last job posts its result before it returns; until it has, retry
+    // shortly (once, however many requests come in) instead of blocking the
+    // event loop on the semaphore
+    if (!renderIdle.tryAcquire()) {
+        if (!renderRetryPending) {
+            renderRetryPending = true;
+            QTimer::singleShot(1, this, [this]() {
+                renderRetryPending = false;
+                requestRender();
+            });
+        }
+        return;
+    }
+    scaleBusy = true;
+    RenderRequest req;
+    req.src = source;
+    req.key = source.cacheKey();
+    req.srcSize = source.size();
+    req.roi = v.roi;
+    req.outSize = v.target.size();
+    req.kernel = scaleKernel;
+    req.mipLevel = v.mipLevel;
+    req.dpr = devicePixelRatioF();
+    QImage buffer = std::move(spare);
+    renderPool()->start([this, req, buffer=std::move(buffer)]() mutable {
+        Trace::nameThreadOnce("render");
+        Trace::Scope trace("render");
+        QElapsedTimer t;
+        t.start();
+        QImage out = renderRoi(req, std::move(buffer));
+        const double ms = t.nsecsElapsed() / 1e6;
+        RenderRequest done = req;
+        done.src = QImage(); // do not pin the frame
+        QMetaObject::invokeMethod(this, [this, out, done, ms]() mutable {
+            scaleMsAvg = scaleMsAvg>0 ? 0.9*scaleMsAvg + 0.1*ms : ms;
+            scaleBusy = false;
+            if (presentOnRequest) {
+                // A render still waiting for its refresh is superseded
+                if (!ready.isNull()) spare = std::move(ready);
+                ready = std::move(out);
+                readyReq = done;
+                emit renderReady();
+            } else {
+                installRender(std::move(out), done);
+            }
+            if (scaleAgain) {
+                scaleAgain = false;
+                requestRender();
+            }
+        }, Qt::QueuedConnection);
+        renderIdle.release();
+    });
+}
+
+QImage ImageWidget::renderRoi(const RenderRequest &r, QImage &&buffer) {
+    QImage level = r.src;
+    QRect roi = r.roi;
+    if (r.mipLevel > 0) {
+        if (mipKey != r.key) {
+            mips.clear();
+            mipKey = r.key;
+        }
+        if (mips.empty()) {
+            const QImage::Format fast = r.src.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+            mips.push_back(r.src.format()==fast ? r.src : r.src.convertToFormat(fast));
+        }
+        while ((int)mips.size() <= r.mipLevel) {
+            const QImage &prev = mips.back();
+            QImage next(std::max(prev.width()/2, 1), std::max(prev.height()/2, 1), prev.format());
+            ScaleKernels::halve(prev.constBits(), size_t(prev.bytesPerLine()), prev.width(), prev.height(),
+                                next.bits(), size_t(next.bytesPerLine()));
+            mips.push_back(next);
+        }
+        level = mips[r.mipLevel];
+        const int f = 1 << r.mipLevel;
+        const int x0 = std::min(roi.left()/f, level.width()-1);
+        const int y0 = std::min(roi.top()/f, level.height()-1);
+        const int x1 = std::clamp((roi.left()+roi.width()+f-1)/f, x0+1, level.width());
+        const int y1 = std::clamp((roi.top()+roi.height()+f-1)/f, y0+1, level.height());
+        roi = QRect(x0, y0, x1-x0, y1-y0);
+    }
+    // Only the visible region is resampled: 32-bit levels are cropped with a
+    // zero-copy view, other formats copy just the ROI before conversion
+    QImage crop;
+    bool view = false;
+    if (roi == level.rect()) {
+        crop = level;
+    } else if (level.depth()==32) {
+        crop = QImage(level.constBits() + roi.y()*level.bytesPerLine() + roi.x()*4,
+                      roi.width(), roi.height(), level.bytesPerLine(), level.format());
+        view = true;
+    } else {
+        crop = level.copy(roi);
+    }
+    QImage out = scaler.scale(crop, r.outSize, r.kernel, std::move(buffer));
+    if (view && out.constBits()==crop.constBits()) out = out.copy(); // must not outlive 'level'
+    out.setDevicePixelRatio(r.dpr);
+    return out;
+}
+
+void ImageWidget::resizeEvent(QResizeEvent *e) {
+    QWidget::resizeEvent(e);
+    requestRender();
+    notifyIngestSize();
+}
+
+void ImageWidget::paintEvent(QPaintEvent *) {
+    if (source.isNull()) return;
+    Trace::Scope trace("paint");
+    QElapsedTimer timer;
+    timer.start();
+    const View v = computeView();
+    lastDrawRect_ = v.image.toAlignedRect();
     QPainter p(this);
-    if (mode!=DisplayMode::StretchToWindow && (lastDrawRect_.width() < avail.width() || lastDrawRect_.height() < avail.height())) {
+    if (!v.image.contains(QRectF(rect()))) {
         p.fillRect(rect(), Qt::black); // letterbox background
     }
-    p.drawImage(lastDrawRect_, source);
-    auto avg = [](const std::deque<double> &d){ if (d.empty()) return 0.0; double s=0; for(double v: d) s+=v; return s/d.size(); };
-    auto minv = [](const std::deque<double> &d){ if (d.empty()) return 0.0; return *std::min_element(d.begin(), d.end()); };
-    auto maxv = [](const std::deque<double> &d){ if (d.empty()) return 0.0; return *std::max_element(d.begin(), d.end()); };
-    double dispFps = avg(dispIntervals)>0 ? 1000.0/avg(dispIntervals) : 0;
-    double minFps = maxv(dispIntervals)>0 ? 1000.0/maxv(dispIntervals) : 0;
-    double maxFps = minv(dispIntervals)>0 ? 1000.0/minv(dispIntervals) : 0;
-    emit displayFpsUpdated(dispFps, minFps, maxFps);
+    bool newFrame = false;
+    if (!cache.isNull()) {
+        if (cacheMatches(v)) {
+            const qreal dpr = devicePixelRatioF();
+            p.drawImage(QRectF(v.target.x()/dpr, v.target.y()/dpr, v.target.width()/dpr, v.target.height()/dpr), cache);
+            newFrame = cacheReq.key != paintedKey;
+            paintedKey = cacheReq.key;
+        } else {
+            // Frame, geometry or zoom changed and the worker has not caught up:
+            // place the previous result under the current mapping meanwhile
+            // (in full-resolution units: the previous frame may have been reduced differently)
+            const QRect &cr = cacheReq.roi;
+            const double fx = v.fullScaleX * fullSize.width() / std::max(cacheReq.srcSize.width(), 1);
+            const double fy = v.fullScaleY * fullSize.height() / std::max(cacheReq.srcSize.height(), 1);
+            p.drawImage(QRectF(v.origin.x() + cr.x()*fx, v.origin.y() + cr.y()*fy,
+                               cr.width()*fx, cr.height()*fy), cache);
+            requestRender();
+        }
+    }
+    drawColorbar(p);
+    drawCaption(p);
+    p.end();
+    const double ms = timer.nsecsElapsed() / 1e6;
+    paintMsAvg = paintMsAvg>0 ? 0.9*paintMsAvg + 0.1*ms : ms;
+    if (newFrame) {
+        // Display rate counts presented frames, not repaints for zoom, hover or resize
+        displayRate.tick();
+        emit framePainted(paintedKey);
+    }
 }
 
 void ImageWidget::mousePressEvent(QMouseEvent *e) {
     if (source.isNull()) return;
-    int x,y; if (!widgetToImage(e->pos(), x,y)) return;
+    const bool zoomed = zoom!=1.0 || pan!=QPointF(fullSize.width()/2.0, fullSize.height()/2.0);
+    // Middle button always pans; left button pans once zoomed, and then the
+    // click is only reported on release if the mouse did not move
+    if (e->button()==Qt::MiddleButton || (e->button()==Qt::LeftButton && zoomed)) {
+        dragging = true;
+        dragMoved = false;
+        dragButton = e->button();
+        dragStart = dragLast = e->position();
+        return;
+    }
+    int x,y; if (!widgetToFull(e->position(), x,y)) return;
     if (e->button()==Qt::LeftButton) emit pixelClickedLeft(x,y);
     else if (e->button()==Qt::RightButton) emit pixelClickedRight(x,y);
 }
 
-void ImageWidget::wheelEvent(QWheelEvent *e) { Q_UNUSED(e); }
+void ImageWidget::mouseReleaseEvent(QMouseEvent *e) {
+    if (!dragging || e->button()!=dragButton) return;
+    dragging = false;
+    unsetCursor();
+    if (dragButton==Qt::LeftButton && !dragMoved) {
+        int x,y; if (widgetToFull(dragStart, x,y)) emit pixelClickedLeft(x,y);
+    }
+}
+
+void ImageWidget::wheelEvent(QWheelEvent *e) {
+    if (source.isNull()) return;
+    const double steps = e->angleDelta().y() / 120.0;
+    if (steps==0.0) return;
+    zoomAt(e->position(), std::pow(1.25, steps));
+    e->accept();
+}
 
 void ImageWidget::mouseMoveEvent(QMouseEvent *e) {
     if (source.isNull()) return;
-    int x,y; if (!widgetToImage(e->pos(), x,y)) return; 
+    if (dragging) {
+        const QPointF pos = e->position();
+        if (!dragMoved && (pos-dragStart).manhattanLength() < 4) return;
+        if (!dragMoved) setCursor(Qt::ClosedHandCursor);
+        dragMoved = true;
+        const View v = computeView();
+        if (v.scaleX > 0.0) {
+            pan -= QPointF((pos.x()-dragLast.x())/v.fullScaleX, (pos.y()-dragLast.y())/v.fullScaleY);
+            clampPan();
+            requestRender();
+            update();
+        }
+        dragLast = pos;
+        return;
+    }
+    int x,y; if (!widgetToImage(e->position(), x,y)) return;
+    int fx,fy; if (!widgetToFull(e->position(), fx,fy)) return;
     QColor c = QColor::fromRgba(source.pixel(x,y));
-    emit pixelHovered(x,y,c.red(),c.green(),c.blue(),c.alpha());
+    emit pixelHovered(fx,fy,c.red(),c.green(),c.blue(),c.alpha());
 }
 
-bool ImageWidget::widgetToImage(const QPoint &wpt, int &ix, int &iy) const {
-    if (source.isNull()) return false;
-    if (!lastDrawRect_.contains(wpt)) return false;
-    int sx = source.width();
-    int sy = source.height();
-    if (mode==DisplayMode::OriginalSize) {
-        ix = wpt.x() - lastDrawRect_.x();
-        iy = wpt.y() - lastDrawRect_.y();
-        if (ix<0||iy<0||ix>=sx||iy>=sy) return false;
-        return true;
-    }
-    if (mode==DisplayMode::StretchToWindow) {
-        double rx = double(wpt.x()) / double(lastDrawRect_.width());
-        double ry = double(wpt.y()) / double(lastDrawRect_.height());
-        ix = std::clamp(int(rx * sx), 0, sx-1);
-        iy = std::clamp(int(ry * sy), 0, sy-1);
-        return true;
-    }
-    if (mode==DisplayMode::AspectRatio) {
-        double rx = double(wpt.x() - lastDrawRect_.x()) / double(lastDrawRect_.width());
-        double ry = double(wpt.y() - lastDrawRect_.y()) / double(lastDrawRect_.height());
-        ix = std::clamp(int(rx * sx), 0, sx-1);
-        iy = std::clamp(int(ry * sy), 0, sy-1);
-        return true;
-    }
-    return false;
+bool ImageWidget::widgetToImage(const QPointF &wpt, int &ix, int &iy) const {
+    // Same mapping the renderer uses, so readout and click ports stay exact at any zoom
+    const View v = computeView();
+    if (v.scaleX <= 0.0 || v.scaleY <= 0.0) return false;
+    ix = int(std::floor((wpt.x()-v.origin.x()) / v.scaleX));
+    iy = int(std::floor((wpt.y()-v.origin.y()) / v.scaleY));
+    return ix>=0 && iy>=0 && ix<source.width() && iy<source.height();
+}
+
+bool ImageWidget::widgetToFull(const QPointF &wpt, int &ix, int &iy) const {
+    const View v = computeView();
+    if (v.fullScaleX <= 0.0 || v.fullScaleY <= 0.0) return false;
+    ix = int(std::floor((wpt.x()-v.origin.x()) / v.fullScaleX));
+    iy = int(std::floor((wpt.y()-v.origin.y()) / v.fullScaleY));
+    return ix>=0 && iy>=0 && ix<fullSize.width() && iy<fullSize.height();
 }
@@ -1,8 +1,13 @@
 #pragma once
 #include <QWidget>
 #include <QImage>
-#include <QElapsedTimer>
-#include <deque>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <vector>
+#include "ImageScaler.h"
+#include "RateStats.h"
+
+class QPainter;
 
 enum class DisplayMode { StretchToWindow, OriginalSize, AspectRatio };
 
@@ -10,38 +15,139 @@ class ImageWidget : public QWidget {
     Q_OBJECT
 public:
     explicit ImageWidget(QWidget *parent=nullptr);
+    ~ImageWidget() override;
 
     QSize sizeHint() const override { return QSize(320,240); }
+    double scaleMs() const { return scaleMsAvg; } // smoothed worker time per scaled frame
+    double paintMs() const { return paintMsAvg; } // smoothed GUI time per paint (blit and overlays)
+    double zoomFactor() const { return zoom; }    // relative to the display mode's fit
+    const RateStats &displayStats() const { return displayRate; } // rate of newly presented frames
+    // Largest source resolution worth delivering for the current mode, size
+    // and zoom (device pixels); null when only full resolution will do.
+    QSize ingestSizeHint() const;
 
 public slots:
-    void setSourceImage(const QImage &img);
+    // fullSize: resolution of the stream when img was reduced at ingest
+    // (clicks and hover are reported in full-resolution coordinates)
+    void setSourceImage(const QImage &img, const QSize &fullSize = QSize());
     void setMode(DisplayMode m);
     void setAutoResize(bool on); // when true, window (outside) will be resized externally, here just note flag
-    void resetZoom(); // deprecated (kept for compatibility)
+    void setScaleKernel(ScaleKernels::Kernel k);
+    void resetZoom(); // back to the display mode's fit, centred
+    // Colorbar legend for colormapped depth images; a null strip hides it
+    void setColorbar(const QImage &strip, double lo, double hi);
+    // Text drawn in the top-left corner (mosaic tile label and stats)
+    void setCaption(const QString &text);
+    // Refresh-driven presentation: finished renders are held back (renderReady
+    // is emitted) until presentRendered() installs the newest one and marks
+    // the widget dirty, so it is painted in the update that called it.
+    void setPresentOnRequest(bool on);
+    bool presentRendered();
 
 signals:
-    void displayFpsUpdated(double avgFps, double minFps, double maxFps);
     void pixelClickedLeft(int x,int y);
     void pixelClickedRight(int x,int y);
     void pixelHovered(int x,int y,int r,int g,int b,int a);
+    // A source image (QImage::cacheKey) was painted for the first time
+    void framePainted(qint64 key);
+    // ingestSizeHint() changed (resize, zoom or mode)
+    void ingestSizeHintChanged();
+    // With setPresentOnRequest(true): a render finished and waits for presentRendered()
+    void renderReady();
 
 protected:
     void paintEvent(QPaintEvent *) override;
+    void resizeEvent(QResizeEvent *e) override;
     void mousePressEvent(QMouseEvent *e) override;
+    void mouseReleaseEvent(QMouseEvent *e) override;
     void mouseMoveEvent(QMouseEvent *e) override;
     void wheelEvent(QWheelEvent *e) override;
 
 private:
+    // Mapping between source pixels and the widget for the current mode/zoom/pan
+    struct View {
+        QPointF origin;         // widget position of source pixel (0,0)
+        double scaleX{0.0};     // widget px per source px
+        double scaleY{0.0};
+        double fullScaleX{0.0}; // widget px per full-resolution px
+        double fullScaleY{0.0};
+        QRectF image;           // whole image in widget coords (may exceed the widget)
+        QRect roi;              // visible source pixels
+        QRect target;           // where roi lands, in device pixels
+        int mipLevel{0};        // pyramid level to resample from
+    };
+    View computeView() const;
+    QRect computeDrawRect() const; // unzoomed placement for the display mode
+    void zoomAt(const QPointF &wpt, double factor);
+    void clampPan();
+
     QImage source; // original image
+    QSize fullSize; // stream resolution (source may be reduced at ingest)
     bool autoResize=false;
     DisplayMode mode{DisplayMode::StretchToWindow};
     QRect lastDrawRect_; // where the image was actually drawn inside the widget
+    ScaleKernels::Kernel scaleKernel{ScaleKernels::Kernel::Nearest};
+
+    // Zoom and pan: pan is the full-resolution point shown at the centre of the fit rect
+    double zoom{1.0};
+    QPointF pan;
+    static constexpr double MIN_ZOOM = 0.1;
+    static constexpr double MAX_ZOOM = 64.0;
+    bool dragging{false};
+    bool dragMoved{false};
+    Qt::MouseButton dragButton{Qt::NoButton};
+    QPointF dragStart;
+    QPointF dragLast;
+
+    // Render cache: the visible source region converted to a device-friendly
+    // format and scaled to its device size by a worker thread; paintEvent only blits.
+    struct RenderRequest {
+        QImage src;
+        qint64 key{0};
+        QSize srcSize;
+        QRect roi;
+        QSize outSize;
+        ScaleKernels::Kernel kernel{ScaleKernels::Kernel::Nearest};
+        int mipLevel{0};
+        qreal dpr{1.0};
+    };
+    QImage cache;
+    QImage spare; // previous cache, recycled as the next output buffer
+    RenderRequest cacheReq; // what cache holds (src left null)
+    bool presentOnRequest{false};
+    QImage ready;           // finished render not yet presented (presentOnRequest)
+    RenderRequest readyReq;
+    ImageScaler scaler;        // used by the render job only
+    std::vector<QImage> mips;  // render job only: lazily built pyramid of one frame
+    qint64 mipKey{0};
+    QSemaphore renderIdle{1};  // held while a render job of this widget runs
+    static QThreadPool *renderPool(); // shared by all widgets (mosaic tiles)
+    bool scaleBusy{false};
+    bool scaleAgain{false};
+    bool renderRetryPending{false}; // a retry is queued while the last job returns
+    double scaleMsAvg{0.0};
+    double paintMsAvg{0.0};
+    qint64 paintedKey{0};
+    QSize deviceSizeFor(const QRect &r) const;
+    bool cacheMatches(const View &v) const { return renderMatches(cache, cacheReq, v); }
+    bool renderMatches(const QImage &img, const RenderRequest &req, const View &v) const;
+    void installRender(QImage &&out, const RenderRequest &req);
+    void requestRender();
+    QImage renderRoi(const RenderRequest &r, QImage &&buffer);
+
+    QImage colorbar; // 256x1 LUT strip
+    double colorbarLo{0.0};
+    double colorbarHi{0.0};
+    QString caption;
+
+    RateStats displayRate;
 
-    // fps stats (display only)
-    QElapsedTimer dispTimer; // time since last paint
-    std::deque<double> dispIntervals;
-    static constexpr int FPS_WINDOW = 120;
+    void drawColorbar(QPainter &p);
+    void drawCaption(QPainter &p);
 
-    // Map widget coordinates to image coordinates based on lastDrawRect_
-    bool widgetToImage(const QPoint &wpt, int &ix, int &iy) const;
+    // Map widget coordinates to source / full-resolution pixel coordinates (any zoom level)
+    bool widgetToImage(const QPointF &wpt, int &ix, int &iy) const;
+    bool widgetToFull(const QPointF &wpt, int &ix, int &iy) const;
+    void notifyIngestSize();
+    QSize lastIngestHint;
 };
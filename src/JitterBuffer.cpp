@@ -0,0 +1,91 @@
+#include "JitterBuffer.h"
+#include <QMutexLocker>
+#include <algorithm>
+
+JitterBuffer::JitterBuffer(int capacity) : capacity(size_t(std::max(capacity, 1))) {}
+
+void JitterBuffer::setTargetDelay(double ms) {
+    QMutexLocker lock(&mutex);
+    delay = std::max(ms, 0.0) / 1000.0;
+    counters.delayMs = delay * 1000.0;
+}
+
+void JitterBuffer::push(FrameMailbox::Frame &&frame, double now) {
+    // Unstamped streams fall back to arrival time (buffered, but not smoothed)
+    const double stamp = frame.stamp.isValid() ? frame.stamp.getTime() : now;
+    QMutexLocker lock(&mutex);
+    if (stamp < lastTakenStamp - 1.0 || stamp < lastPushStamp - 1.0) {
+        // Stamps went back in time: publisher restart, start over
+        restart();
+    }
+    // Sliding-window minimum: a sample that can no longer be the minimum
+    // is dropped on arrival, expired ones from the front
+    const double transit = now - stamp;
+    while (!transits.empty() && transits.back().second >= transit) transits.pop_back();
+    transits.emplace_back(now, transit);
+    while (transits.front().first < now - OFFSET_WINDOW_S) transits.pop_front();
+    offset = transits.front().second;
+
+    if (lastPushStamp >= 0.0 && stamp > lastPushStamp) {
+        const double d = stamp - lastPushStamp;
+        frameInterval = frameInterval > 0.0 ? 0.9*frameInterval + 0.1*d : d;
+    }
+    lastPushStamp = std::max(lastPushStamp, stamp);
+    if (stamp <= lastTakenStamp) {
+        counters.late++; // older than what is on screen
+        return;
+    }
+    // Starved: the frame after the one on screen was due while nothing was buffered
+    if (entries.empty() && lastTakenStamp >= 0.0 && frameInterval > 0.0
+        && lastTakenStamp + frameInterval + offset + delay < now) {
+        counters.underruns++;
+    }
+    const double due = stamp + offset + delay;
+
+    auto pos = std::upper_bound(entries.begin(), entries.end(), stamp,
+        [](double s, const Entry &e) { return s < e.stamp; });
+    entries.insert(pos, Entry{std::move(frame), stamp, due});
+    while (entries.size() > capacity) {
+        entries.pop_front();
+        counters.overruns++;
+    }
+    counters.depth = int(entries.size());
+}
+
+bool JitterBuffer::take(double now, FrameMailbox::Frame &out, double &nextDue) {
+    QMutexLocker lock(&mutex);
+    bool found = false;
+    double taken = 0.0;
+    while (!entries.empty() && entries.front().due <= now) {
+        // Behind schedule: only the newest due frame is shown, the rest are lost
+        if (found) counters.superseded++;
+        out = std::move(entries.front().frame);
+        taken = entries.front().stamp;
+        entries.pop_front();
+        found = true;
+    }
+    if (found) lastTakenStamp = taken;
+    nextDue = entries.empty() ? 0.0 : entries.front().due;
+    counters.depth = int(entries.size());
+    return found;
+}
+
+JitterBuffer::Stats JitterBuffer::stats() const {
+    QMutexLocker lock(&mutex);
+    return counters;
+}
+
+void JitterBuffer::clear() {
+    QMutexLocker lock(&mutex);
+    restart();
+    counters = Stats();
+    counters.delayMs = delay * 1000.0;
+}
+
+void JitterBuffer::restart() {
+    entries.clear();
+    transits.clear();
+    lastPushStamp = -1.0;
+    frameInterval = 0.0;
+    lastTakenStamp = -1.0;
+}
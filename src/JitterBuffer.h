@@ -0,0 +1,56 @@
+#pragma once
+#include <QMutex>
+#include <deque>
+#include <utility>
+#include "FrameMailbox.h"
+
+// Playout buffer for bursty streams: frames are held in stamp order and
+// released at their publisher-relative time plus a fixed target delay.
+// The publisher->local clock offset is the smallest transit of the last
+// few seconds, so clocks need not be synchronised and drift or a slower
+// route is followed without the estimate wandering off the minimum.
+// push() runs on the port reader thread, take() on the GUI thread.
+class JitterBuffer {
+public:
+    struct Stats {
+        int depth{0};
+        quint64 underruns{0}; // times the buffer was empty when a frame was due
+        quint64 overruns{0};  // frames dropped because the buffer was full
+        quint64 late{0};      // frames not newer than the one on screen, discarded
+        quint64 superseded{0}; // due together with a newer frame and never shown
+        double delayMs{0.0};
+    };
+
+    explicit JitterBuffer(int capacity=8);
+
+    void setTargetDelay(double ms);
+    // now: local time (yarp::os::Time::now()) of arrival
+    void push(FrameMailbox::Frame &&frame, double now);
+    // Pops the newest frame due by now (older due ones are superseded).
+    // nextDue is the local due time of the next buffered frame, or 0.
+    bool take(double now, FrameMailbox::Frame &out, double &nextDue);
+    Stats stats() const;
+    void clear();
+
+private:
+    struct Entry {
+        FrameMailbox::Frame frame;
+        double stamp{0.0}; // ordering key: envelope time, or arrival if unstamped
+        double due{0.0};
+    };
+
+    void restart();
+
+    mutable QMutex mutex;
+    std::deque<Entry> entries; // ascending stamp
+    size_t capacity;
+    double delay{0.0};        // s
+    double offset{0.0};       // local - publisher, s
+    // (arrival, transit) candidates for the windowed minimum, ascending transit
+    std::deque<std::pair<double, double>> transits;
+    double lastPushStamp{-1.0};
+    double frameInterval{0.0}; // publisher frame period estimate, s
+    double lastTakenStamp{-1.0};
+    Stats counters;
+    static constexpr double OFFSET_WINDOW_S = 5.0;
+};
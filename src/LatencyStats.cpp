@@ -0,0 +1,56 @@
+#include "LatencyStats.h"
+#include <algorithm>
+#include <cmath>
+
+void LatencyHistogram::add(double ms) {
+    if (!(ms >= 0.0)) return; // NaN or clock skew making a stage negative
+    const int idx = ms > MIN_MS ? int(std::log2(ms / MIN_MS) * BUCKETS_PER_OCTAVE) : 0;
+    buckets[std::min(idx, int(buckets.size()) - 1)]++;
+    n++;
+    maxMs = std::max(maxMs, ms);
+}
+
+void LatencyHistogram::reset() {
+    buckets.fill(0);
+    n = 0;
+    maxMs = 0.0;
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (n == 0) return 0.0;
+    const quint64 rank = std::max<quint64>(1, quint64(std::ceil(p * double(n))));
+    quint64 seen = 0;
+    for (size_t i=0; i<buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // Geometric centre of the bucket, never above the observed max
+            const double centre = MIN_MS * std::exp2((double(i) + 0.5) / BUCKETS_PER_OCTAVE);
+            return std::min(centre, maxMs);
+        }
+    }
+    return maxMs;
+}
+
+const char *LatencyStats::stageName(Stage s) {
+    switch (s) {
+    case Transport: return "transport";
+    case Convert: return "convert";
+    case Queue: return "queue";
+    case Render: return "render";
+    case Total: return "total";
+    default: break;
+    }
+    return "?";
+}
+
+QString LatencyStats::summary(Stage s) const {
+    const LatencyHistogram &h = stages[s];
+    if (h.count() == 0) return QString("-");
+    return QString("%1/%2/%3/%4")
+        .arg(h.percentile(0.50),0,'f',1).arg(h.percentile(0.95),0,'f',1)
+        .arg(h.percentile(0.99),0,'f',1).arg(h.max(),0,'f',1);
+}
+
+void LatencyStats::reset() {
+    for (LatencyHistogram &h : stages) h.reset();
+}
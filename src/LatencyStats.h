@@ -0,0 +1,46 @@
+#pragma once
+#include <QString>
+#include <array>
+
+// Log-bucketed latency histogram: 8 buckets per octave from 10 us to ~10 s,
+// so percentiles are within ~9% and adding a sample is O(1).
+class LatencyHistogram {
+public:
+    void add(double ms);
+    void reset();
+    quint64 count() const { return n; }
+    double percentile(double p) const; // p in [0,1], ms
+    double max() const { return maxMs; }
+
+private:
+    static constexpr int BUCKETS_PER_OCTAVE = 8;
+    static constexpr int OCTAVES = 20;
+    static constexpr double MIN_MS = 0.01;
+    std::array<quint64, BUCKETS_PER_OCTAVE*OCTAVES> buckets{};
+    quint64 n{0};
+    double maxMs{0.0};
+};
+
+// Per-stage latency of displayed frames, from the publisher's envelope stamp
+// to the end of the paint that first shows the frame.
+class LatencyStats {
+public:
+    enum Stage {
+        Transport, // envelope stamp -> onRead entry (needs synchronised clocks)
+        Convert,   // onRead entry -> converted frame published
+        Queue,     // published -> taken by the GUI thread
+        Render,    // taken -> paint complete (scaling and repaint scheduling)
+        Total,     // envelope stamp -> paint complete
+        STAGE_COUNT
+    };
+
+    static const char *stageName(Stage s);
+    LatencyHistogram &stage(Stage s) { return stages[s]; }
+    const LatencyHistogram &stage(Stage s) const { return stages[s]; }
+    // "p50/p95/p99/max" in ms, or "-" without samples
+    QString summary(Stage s) const;
+    void reset();
+
+private:
+    std::array<LatencyHistogram, STAGE_COUNT> stages;
+};
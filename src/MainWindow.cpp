@@ -1,5 +1,8 @@
 // Rewritten implementation with corrected auto-resize semantics, display modes, and status panels
 #include "MainWindow.h"
+#include "FramePool.h"
+#include "ReceiverStats.h"
+#include "Trace.h"
 #include <QMenuBar>
 #include <QStatusBar>
 #include <QFileDialog>
@@ -9,11 +12,18 @@
 #include <QDir>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include <QGridLayout>
 #include <QResizeEvent>
 #include <QGuiApplication>
+#include <QScreen>
 #include <QTimer>
 #include <yarp/os/Network.h>
 #include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
 
 MainWindow::MainWindow(const YarpViewOptions &opt, QWidget *parent) : QMainWindow(parent), options(opt) {
     buildUi();
@@ -34,9 +44,90 @@ MainWindow::MainWindow(const YarpViewOptions &opt, QWidget *parent) : QMainWindo
         setWindowFlags(f);
     }
     openPorts();
-    receiver.open(options.imgInputPortName, true);
-    connect(&receiver, &ImageReceiver::imageArrived, this, &MainWindow::onImage);
-    if (!options.synch) {
+    {
+        DepthColormap::Settings depth;
+        depth.enabled = options.depth;
+        if (!DepthColormap::mapFromName(options.colormap.c_str(), depth.map)) {
+            yWarning() << "Unknown colormap" << options.colormap << "- using jet";
+            depth.map = DepthColormap::Map::Jet;
+        }
+        depth.autoRange = options.depthAutoRange;
+        depth.nearValue = float(options.depthNear);
+        depth.farValue = float(options.depthFar);
+        applyDepthSettings(depth);
+    }
+    if (!ImageReceiver::readPolicyFromName(options.readPolicy.c_str(), readPolicy)) {
+        yWarning() << "Unknown policy" << options.readPolicy << "- using latest";
+    }
+    receiver.setReadPolicy(readPolicy, options.queueDepth);
+    if (options.syncToleranceMs > 0.0) {
+        if (!mosaic()) {
+            yWarning() << "--sync-tolerance needs --input ports to match against, ignored";
+        } else {
+            matcher = std::make_unique<StampMatcher>(1 + int(tiles.size()), options.syncToleranceMs, options.syncQueue);
+            receiver.setMatcher(matcher.get(), 0);
+            for (size_t i=0; i<tiles.size(); ++i) tiles[i]->receiver->setMatcher(matcher.get(), int(i+1));
+            if (options.jitterDelayMs > 0.0) {
+                yWarning() << "--jitter-buffer is ignored with --sync-tolerance";
+                options.jitterDelayMs = 0.0;
+            }
+        }
+    }
+    receiver.setJitterBuffer(options.jitterDelayMs);
+    if (options.flightSeconds > 0.0) {
+        FlightRecorder::Settings fs;
+        fs.seconds = options.flightSeconds;
+        fs.budgetMB = options.flightMB;
+        fs.compress = options.flightCompress;
+        flight = std::make_unique<FlightRecorder>(fs);
+        receiver.setFlightRecorder(flight.get());
+        statusRecord->setVisible(true);
+    }
+    actFlightDump->setEnabled(flight != nullptr);
+    if (options.relayEnabled) {
+        StreamRelay::Settings rs;
+        rs.scale = options.relayScale;
+        rs.maxRate = options.relayRate;
+        rs.jpegQuality = options.relayJpegQuality;
+        relay = std::make_unique<StreamRelay>(rs);
+        if (relay->open(options.relayOutPortName)) {
+            receiver.setRelay(relay.get());
+            statusRecord->setVisible(true);
+        } else {
+            relay.reset();
+        }
+    }
+    jitterTimer = new QTimer(this);
+    jitterTimer->setSingleShot(true);
+    jitterTimer->setTimerType(Qt::PreciseTimer);
+    connect(jitterTimer, &QTimer::timeout, this, &MainWindow::serviceJitterBuffer);
+    if (!options.replayFile.empty()) {
+        const QString file = QString::fromStdString(options.replayFile);
+        if (!receiver.openReplay(file, options.replaySpeed, options.replayLoop)) {
+            QMessageBox::warning(this, "Replay", "Cannot play " + file);
+        }
+    } else {
+        receiver.setCompressedInput(options.compressedInput, options.decodeThreads);
+        if (receiver.open(options.imgInputPortName, true) && !options.connectSource.empty()) {
+            receiver.connectSource(options.connectSource, options.carrier);
+        }
+    }
+    if (!options.recordFile.empty()) {
+        if (receiver.startRecording(QString::fromStdString(options.recordFile))) {
+            actRecordStream->setText("Stop recording stream");
+            statusRecord->setVisible(true);
+        }
+    }
+    connect(&receiver, &ImageReceiver::frameAvailable, this, &MainWindow::onFrameAvailable);
+    openTiles();
+    // --vsync: renders wait for the screen refresh they are requested for
+    connect(imageWidget, &ImageWidget::renderReady, this, &MainWindow::scheduleRefresh);
+    imageWidget->setPresentOnRequest(options.vsync);
+    for (auto &t : tiles) {
+        connect(t->widget, &ImageWidget::renderReady, this, &MainWindow::scheduleRefresh);
+        t->widget->setPresentOnRequest(options.vsync);
+    }
+    if (!options.synch && !options.vsync) {
         displayTimer = new QTimer(this);
         displayTimer->setInterval(options.refreshMs);
         connect(displayTimer, &QTimer::timeout, this, &MainWindow::displayTick);
@@ -55,26 +146,68 @@ MainWindow::MainWindow(const YarpViewOptions &opt, QWidget *parent) : QMainWindo
             resize(w,h);
         } else {
             if (!(options.hasW || options.hasH)) {
-                setClientImageSize(320,240);
+                const auto *grid = qobject_cast<QGridLayout*>(centralWidget()->layout());
+                if (grid) setClientImageSize(320*grid->columnCount(), 240*grid->rowCount());
+                else setClientImageSize(320,240);
             }
         }
     }
-    portTimer.start();
+    // Labels refresh at a fixed low rate, independent of port and paint rates
+    statusTimer = new QTimer(this);
+    statusTimer->setInterval(STATUS_PERIOD_MS);
+    connect(statusTimer, &QTimer::timeout, this, &MainWindow::updateStatus);
+    statusTimer->start();
 }
 
 MainWindow::~MainWindow() {
     receiver.close();
+    for (auto &t : tiles) t->receiver->close();
     if (options.leftClickEnabled) leftClickPort.close();
     if (options.rightClickEnabled) rightClickPort.close();
+    if (options.statsEnabled) statsPort.close();
+    if (flight) flightPort.close();
 }
 
 void MainWindow::buildUi() {
     imageWidget = new ImageWidget(this);
-    setCentralWidget(imageWidget);
+    if (options.mosaicInputs.empty()) {
+        setCentralWidget(imageWidget);
+    } else {
+        // Main stream first, then the --input ports, row by row in a near-square grid
+        QWidget *mosaicPanel = new QWidget(this);
+        QGridLayout *grid = new QGridLayout(mosaicPanel);
+        grid->setContentsMargins(0,0,0,0);
+        grid->setSpacing(2);
+        const int count = 1 + int(options.mosaicInputs.size());
+        const int cols = int(std::ceil(std::sqrt(double(count))));
+        grid->addWidget(imageWidget, 0, 0);
+        for (int i=1; i<count; ++i) {
+            auto tile = std::make_unique<Tile>();
+            tile->name = QString::fromStdString(options.mosaicInputs[size_t(i-1)]);
+            tile->receiver = std::make_unique<ImageReceiver>();
+            tile->widget = new ImageWidget(mosaicPanel);
+            grid->addWidget(tile->widget, i/cols, i%cols);
+            tiles.push_back(std::move(tile));
+        }
+        setCentralWidget(mosaicPanel);
+    }
+    {
+        ScaleKernels::Kernel k = ScaleKernels::Kernel::Nearest;
+        if (!ScaleKernels::kernelFromName(options.scaling.c_str(), k)) {
+            yWarning() << "Unknown scaling kernel" << options.scaling << "- using nearest";
+        }
+        options.scaling = ScaleKernels::kernelName(k);
+        imageWidget->setScaleKernel(k);
+        for (auto &t : tiles) t->widget->setScaleKernel(k);
+    }
     setWindowTitle(options.windowTitle);
     statusPortName = new QLabel(QString::fromStdString(options.imgInputPortName), this);
     statusPort = new QLabel("Port: -", this);
     statusDisplay = new QLabel("Display: -", this);
+    statusLatency = new QLabel("Latency: -", this);
+    statusMemory = new QLabel("Pool: -", this);
+    statusRecord = new QLabel("Rec: -", this);
+    statusRecord->setVisible(false); // shown once a set is being saved
     statusPixelValue = new QLabel("Pixel: -", this);
     statusPixelPatch = new QLabel(this);
     statusPixelPatch->setFixedWidth(24); // will adjust height later
@@ -89,7 +222,13 @@ void MainWindow::buildUi() {
     vbox->addWidget(statusPort);
     // Row 3: Display stats
     vbox->addWidget(statusDisplay);
-    // Row 4: Pixel value (label + inline color patch closely spaced)
+    // Row 4: Latency percentiles
+    vbox->addWidget(statusLatency);
+    // Row 5: Frame buffer pool
+    vbox->addWidget(statusMemory);
+    // Row 6: Image set recorder
+    vbox->addWidget(statusRecord);
+    // Row 7: Pixel value (label + inline color patch closely spaced)
     {
         QWidget *pixelRow = new QWidget(this);
         QHBoxLayout *ph = new QHBoxLayout(pixelRow);
@@ -104,7 +243,8 @@ void MainWindow::buildUi() {
         vbox->addWidget(pixelRow);
     }
     statusBar()->addPermanentWidget(statusPanel, 1);
-    connect(imageWidget, &ImageWidget::displayFpsUpdated, this, &MainWindow::updateDisplayFps);
+    connect(imageWidget, &ImageWidget::framePainted, this, &MainWindow::onFramePainted);
+    connect(imageWidget, &ImageWidget::ingestSizeHintChanged, this, &MainWindow::updateIngestSize);
     connect(imageWidget, &ImageWidget::pixelClickedLeft, this, &MainWindow::onLeftClick);
     connect(imageWidget, &ImageWidget::pixelClickedRight, this, &MainWindow::onRightClick);
     connect(imageWidget, &ImageWidget::pixelHovered, this, [this](int x,int y,int r,int g,int b,int a){
@@ -142,6 +282,14 @@ void MainWindow::createMenus() {
     actSaveSet = new QAction("Save a set of images", this);
     connect(actSaveSet, &QAction::triggered, this, &MainWindow::saveImageSet);
     fileMenu->addAction(actSaveSet);
+    actRecordStream = new QAction("Record stream...", this);
+    connect(actRecordStream, &QAction::triggered, this, &MainWindow::toggleStreamRecording);
+    fileMenu->addAction(actRecordStream);
+    actFlightDump = new QAction("Dump Flight Recorder", this);
+    actFlightDump->setShortcut(QKeySequence(Qt::Key_F9));
+    connect(actFlightDump, &QAction::triggered, this, &MainWindow::dumpFlightRecorder);
+    fileMenu->addAction(actFlightDump);
+    addAction(actFlightDump); // hotkey also with the menu bar hidden
 
     QMenu *imageMenu = menuBar()->addMenu("&Image");
     actOriginalSize = new QAction("Original Size", this);
@@ -152,21 +300,54 @@ void MainWindow::createMenus() {
     actOriginalAspect->setCheckable(true);
     connect(actOriginalAspect, &QAction::triggered, this, &MainWindow::originalAspectRatio);
     imageMenu->addAction(actOriginalAspect);
+    actResetZoom = new QAction("Reset Zoom", this);
+    actResetZoom->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_0));
+    connect(actResetZoom, &QAction::triggered, imageWidget, &ImageWidget::resetZoom);
+    imageMenu->addAction(actResetZoom);
     imageMenu->addSeparator();
     actFreeze = new QAction("Freeze", this);
     actFreeze->setCheckable(true);
     connect(actFreeze, &QAction::triggered, this, &MainWindow::toggleFreeze);
     imageMenu->addAction(actFreeze);
+    actStepBack = new QAction("Step Back", this);
+    actStepBack->setShortcut(QKeySequence(Qt::Key_Left));
+    actStepBack->setEnabled(false); // frozen with a flight recorder only
+    connect(actStepBack, &QAction::triggered, this, &MainWindow::stepBack);
+    imageMenu->addAction(actStepBack);
+    addAction(actStepBack);
+    actStepForward = new QAction("Step Forward", this);
+    actStepForward->setShortcut(QKeySequence(Qt::Key_Right));
+    actStepForward->setEnabled(false);
+    connect(actStepForward, &QAction::triggered, this, &MainWindow::stepForward);
+    imageMenu->addAction(actStepForward);
+    addAction(actStepForward);
     actSynch = new QAction("Synch Display", this);
     actSynch->setCheckable(true);
     actSynch->setChecked(options.synch);
     connect(actSynch, &QAction::triggered, this, &MainWindow::toggleSynch);
     imageMenu->addAction(actSynch);
+    actVsync = new QAction("Present on Screen Refresh", this);
+    actVsync->setCheckable(true);
+    actVsync->setChecked(options.vsync);
+    connect(actVsync, &QAction::triggered, this, &MainWindow::toggleVsync);
+    imageMenu->addAction(actVsync);
     actAutoResize = new QAction("Auto Resize", this);
     actAutoResize->setCheckable(true);
     actAutoResize->setChecked(options.autosize);
     connect(actAutoResize, &QAction::triggered, this, &MainWindow::toggleAutoResize);
     imageMenu->addAction(actAutoResize);
+    QMenu *scalingMenu = imageMenu->addMenu("Scaling");
+    scalingGroup = new QActionGroup(this);
+    for (ScaleKernels::Kernel k : {ScaleKernels::Kernel::Nearest, ScaleKernels::Kernel::Bilinear, ScaleKernels::Kernel::Area}) {
+        QString name = ScaleKernels::kernelName(k);
+        QAction *a = new QAction(name.left(1).toUpper() + name.mid(1), this);
+        a->setCheckable(true);
+        a->setChecked(options.scaling == ScaleKernels::kernelName(k));
+        a->setData(int(k));
+        scalingGroup->addAction(a);
+        scalingMenu->addAction(a);
+    }
+    connect(scalingGroup, &QActionGroup::triggered, this, &MainWindow::setScaling);
     imageMenu->addSeparator();
     actDisplayPixelValue = new QAction("Display Pixel Value", this);
     actDisplayPixelValue->setCheckable(true);
@@ -176,6 +357,34 @@ void MainWindow::createMenus() {
     actChangeRefresh = new QAction("Change Refresh Interval...", this);
     connect(actChangeRefresh, &QAction::triggered, this, &MainWindow::changeRefreshInterval);
     imageMenu->addAction(actChangeRefresh);
+    QAction *actResetLatency = new QAction("Reset Latency Statistics", this);
+    connect(actResetLatency, &QAction::triggered, this, &MainWindow::resetLatencyStats);
+    imageMenu->addAction(actResetLatency);
+
+    imageMenu->addSeparator();
+    QMenu *depthMenu = imageMenu->addMenu("Depth Colormap");
+    depthMapGroup = new QActionGroup(this);
+    const std::pair<const char*, int> maps[] = {
+        {"Off", -1},
+        {"Gray", int(DepthColormap::Map::Gray)},
+        {"Jet", int(DepthColormap::Map::Jet)},
+        {"Turbo", int(DepthColormap::Map::Turbo)}
+    };
+    for (const auto &m : maps) {
+        QAction *a = depthMenu->addAction(m.first);
+        a->setCheckable(true);
+        a->setData(m.second);
+        depthMapGroup->addAction(a);
+    }
+    connect(depthMapGroup, &QActionGroup::triggered, this, &MainWindow::setDepthColormap);
+    depthMenu->addSeparator();
+    actDepthAutoRange = new QAction("Auto Range", this);
+    actDepthAutoRange->setCheckable(true);
+    connect(actDepthAutoRange, &QAction::triggered, this, &MainWindow::toggleDepthAutoRange);
+    depthMenu->addAction(actDepthAutoRange);
+    QAction *actDepthRange = new QAction("Set Range...", this);
+    connect(actDepthRange, &QAction::triggered, this, &MainWindow::changeDepthRange);
+    depthMenu->addAction(actDepthRange);
 
     imageMenu->addSeparator();
     actKeepAbove = new QAction("Keep Above", this);
@@ -197,25 +406,207 @@ void MainWindow::openPorts() {
     if (options.rightClickEnabled) {
         if (!rightClickPort.open(options.rightClickOutPortName)) yError() << "Cannot open right click output port" << options.rightClickOutPortName;
     }
+    if (options.statsEnabled) {
+        if (!statsPort.open(options.statsOutPortName)) {
+            yError() << "Cannot open stats output port" << options.statsOutPortName;
+        } else {
+            statsTimer = new QTimer(this);
+            statsTimer->setInterval(options.statsPeriodMs);
+            connect(statsTimer, &QTimer::timeout, this, &MainWindow::publishStats);
+            statsTimer->start();
+        }
+    }
+    if (options.flightSeconds > 0.0) {
+        if (!flightPort.open(options.flightTriggerPortName)) yError() << "Cannot open flight recorder trigger port" << options.flightTriggerPortName;
+    }
 }
 
-void MainWindow::onImage(const QImage &img, const yarp::os::Stamp &stamp) {
-    Q_UNUSED(stamp);
-    double ms = portTimer.restart();
-    if (ms>0) {
-        portIntervals.push_back(ms);
-        if ((int)portIntervals.size()>PORT_WINDOW) portIntervals.pop_front();
+void MainWindow::pollFlightTrigger() {
+    // Any message dumps; a string in it names the file
+    if (!flight) return;
+    if (ReceiverStats::pollFlightTrigger(flightPort, *flight, QString::fromStdString(options.flightDir)) > 0) {
+        statusRecord->setVisible(true);
     }
+}
+
+void MainWindow::dumpFlightRecorder() { dumpFlightRecorderTo(QString()); }
+
+void MainWindow::dumpFlightRecorderTo(const QString &fileName) {
+    if (!flight) return;
+    const QString path = FlightRecorder::dumpPath(QString::fromStdString(options.flightDir), fileName);
+    if (path.isEmpty()) return;
+    flight->dump(path);
+    statusRecord->setVisible(true);
+}
+
+void MainWindow::stepFlight(int delta) {
+    if (!flight || !receiver.isFrozen()) return;
+    const int n = flight->frameCount();
+    if (n == 0) return;
+    if (flightIndex < 0) flightIndex = n - 1; // the frozen frame is the newest one kept
+    flightIndex = std::clamp(flightIndex + delta, 0, n - 1);
+    FrameMailbox::Frame f;
+    if (!receiver.flightFrame(flightIndex, f)) return;
+    bufferedImage = f.image;
+    bufferedFullSize = f.fullSize;
+    hasBufferedImage = true;
+    lastImgW = f.fullSize.width();
+    lastImgH = f.fullSize.height();
+    presentedGeneration = ++frameGeneration;
+    updateDisplayMode(false);
+    imageWidget->setSourceImage(bufferedImage, bufferedFullSize);
+}
+
+void MainWindow::openTiles() {
+    const DepthColormap::Settings depth = receiver.depthSettings();
+    for (auto &t : tiles) {
+        Tile *tile = t.get();
+        tile->receiver->setDepthSettings(depth);
+        tile->receiver->setCompressedInput(options.compressedInput, options.decodeThreads);
+        tile->receiver->setReadPolicy(readPolicy, options.queueDepth);
+        tile->receiver->open(tile->name.toStdString(), true);
+        // Tiles present on arrival: no latency bookkeeping, no jitter buffer.
+        // Synchronized, they wait for a complete set like the main stream.
+        connect(tile->receiver.get(), &ImageReceiver::frameAvailable, this, [this, tile]() {
+            if (matcher) {
+                onFrameAvailable();
+                return;
+            }
+            FrameMailbox::Frame f;
+            if (!tile->receiver->takeLatest(f)) return;
+            tile->widget->setSourceImage(f.image, f.fullSize);
+        });
+        connect(tile->widget, &ImageWidget::ingestSizeHintChanged, this, [tile]() {
+            tile->receiver->setIngestSize(tile->widget->ingestSizeHint());
+        });
+    }
+}
+
+void MainWindow::updateIngestSize() {
+    const bool fullResolution = recorder.isRecording() || (actDisplayPixelValue && actDisplayPixelValue->isChecked());
+    receiver.setIngestSize(fullResolution ? QSize() : imageWidget->ingestSizeHint());
+}
+
+void MainWindow::onFrameAvailable() {
+    Trace::Scope trace("frameAvailable");
+    if (receiver.jitterBufferEnabled()) serviceJitterBuffer();
+    else if (options.vsync) displayTick(); // render now, present on the next refresh
+    else pullFrame();
+}
+
+void MainWindow::serviceJitterBuffer() {
+    // Buffered frames are presented when due rather than on arrival
+    if (pullFrame() && !options.synch) displayTick();
+}
+
+void MainWindow::scheduleRefresh() {
+    // A request lost with a hidden window is renewed after a second
+    if ((refreshPending && refreshRequested.elapsed() < 1000) || !filteredWindow) return;
+    refreshPending = true;
+    refreshRequested.start();
+    filteredWindow->requestUpdate();
+}
+
+bool MainWindow::eventFilter(QObject *obj, QEvent *ev) {
+    if (obj == filteredWindow && ev->type() == QEvent::UpdateRequest && refreshPending) {
+        refreshPending = false;
+        // Only renders that are already finished: the filter runs before the
+        // window handles the event, so the widgets marked dirty here are
+        // painted in this same update
+        imageWidget->presentRendered();
+        for (auto &t : tiles) t->widget->presentRendered();
+    }
+    return QMainWindow::eventFilter(obj, ev);
+}
+
+bool MainWindow::takeMatchedSet(FrameMailbox::Frame &main) {
+    // Re-arm before taking, as takeLatest() does: no set can go unannounced
+    receiver.acknowledge();
+    for (auto &t : tiles) t->receiver->acknowledge();
+    StampMatcher::Set set;
+    if (!matcher->take(set)) return false;
+    main = std::move(set.frames[0]);
+    matchedTileFrames.assign(std::make_move_iterator(set.frames.begin() + 1),
+                             std::make_move_iterator(set.frames.end()));
+    return true;
+}
+
+QString MainWindow::syncSummary() const {
+    const StampMatcher::Stats s = matcher->stats();
+    const double matchedPct = s.pushed ? 100.0 * double(s.matched * quint64(matcher->ports())) / double(s.pushed) : 0.0;
+    return QString("sync: %1 sets (%2% of frames), skew p50/p95 %3/%4 ms, unmatched %5, superseded %6")
+           .arg(s.matched).arg(matchedPct,0,'f',1)
+           .arg(s.skew.percentile(0.5),0,'f',2).arg(s.skew.percentile(0.95),0,'f',2)
+           .arg(s.unmatched).arg(s.superseded);
+}
+
+bool MainWindow::pullFrame() {
+    FrameMailbox::Frame f;
+    if (matcher) {
+        if (!takeMatchedSet(f)) return false;
+    } else if (receiver.jitterBufferEnabled()) {
+        double nextDue = 0.0;
+        const bool got = receiver.takeDue(f, nextDue);
+        if (nextDue > 0.0) {
+            jitterTimer->start(std::max(0, int(std::ceil((nextDue - yarp::os::Time::now()) * 1000.0))));
+        }
+        if (!got) return false;
+    } else if (!receiver.takeLatest(f)) {
+        return false;
+    }
+    Trace::Scope trace("pullFrame", f.stamp.getCount());
+    const double now = yarp::os::Time::now();
+    // Recorded stamps are from another time: no transport/total for replays
+    const bool live = f.stamp.isValid() && !receiver.isReplaying();
+    if (live) latency.stage(LatencyStats::Transport).add((f.readTime - f.stamp.getTime())*1000.0);
+    latency.stage(LatencyStats::Convert).add((f.publishTime - f.readTime)*1000.0);
+    latency.stage(LatencyStats::Queue).add((now - f.publishTime)*1000.0);
+    pendingPaints.push_back(PendingPaint{f.image.cacheKey(), live ? f.stamp.getTime() : 0.0, now, f.stamp.getCount()});
+    if ((int)pendingPaints.size() > MAX_PENDING_PAINTS) pendingPaints.pop_front();
+    onImage(f.image, f.fullSize, f.stamp);
+    return true;
+}
+
+void MainWindow::onFramePainted(qint64 key) {
+    const double now = yarp::os::Time::now();
+    while (!pendingPaints.empty()) {
+        PendingPaint p = pendingPaints.front();
+        pendingPaints.pop_front(); // older entries were superseded before being shown
+        if (p.key != key) continue;
+        Trace::instant("framePainted", p.seq);
+        if (options.vsync) {
+            // Deadline: on screen by the end of the refresh after the one it was taken in
+            const qreal hz = (filteredWindow && filteredWindow->screen()) ? filteredWindow->screen()->refreshRate() : 60.0;
+            const double periodMs = 1000.0 / (hz > 0 ? hz : 60.0);
+            if ((now - p.takenTime)*1000.0 > 2.0 * periodMs) {
+                missedRefreshes++;
+                Trace::instant("missedRefresh", p.seq);
+            }
+        }
+        latency.stage(LatencyStats::Render).add((now - p.takenTime)*1000.0);
+        if (p.stampTime > 0.0) latency.stage(LatencyStats::Total).add((now - p.stampTime)*1000.0);
+        return;
+    }
+}
+
+void MainWindow::resetLatencyStats() {
+    latency.reset();
+    pendingPaints.clear();
+}
+
+void MainWindow::onImage(const QImage &img, const QSize &fullSize, const yarp::os::Stamp &stamp) {
+    // Taken from the mailbox but replaced before a display tick showed it
+    if (hasBufferedImage && frameGeneration != presentedGeneration) supersededFrames++;
     bufferedImage = img;
+    bufferedFullSize = fullSize.isValid() ? fullSize : img.size();
     hasBufferedImage = true;
-    lastImgW = img.width();
-    lastImgH = img.height();
+    frameGeneration++;
+    lastImgW = bufferedFullSize.width();
+    lastImgH = bufferedFullSize.height();
     if (lastImgW>0 && lastImgH>0) currentImageAspect = double(lastImgH)/double(lastImgW);
     if (options.synch) displayTick();
-    if (savingImageSet && !imageSetDirectory.isEmpty()) {
-        QString filename = QString("%1/image_%2.png").arg(imageSetDirectory).arg(imageSetCounter++, 6, 10, QChar('0'));
-        img.save(filename);
-    }
+    // Frames reduced before recording switched ingest to full resolution are skipped
+    if (img.size() == bufferedFullSize) recorder.push(img, stamp);
 }
 
 void MainWindow::onLeftClick(int x,int y) {
@@ -227,25 +618,296 @@ void MainWindow::onRightClick(int x,int y) {
     auto &b = rightClickPort.prepare(); b.clear(); b.addInt32(x); b.addInt32(y); rightClickPort.write();
 }
 
-void MainWindow::updateDisplayFps(double dispFps, double minFps, double maxFps) {
-    auto avg = [](const std::deque<double> &d){ if (d.empty()) return 0.0; double s=0; for(double v: d) s+=v; return s/d.size(); };
-    auto minv = [](const std::deque<double> &d){ if (d.empty()) return 0.0; return *std::min_element(d.begin(), d.end()); };
-    auto maxv = [](const std::deque<double> &d){ if (d.empty()) return 0.0; return *std::max_element(d.begin(), d.end()); };
-    double avgMs = avg(portIntervals);
-    double portHz = avgMs>0 ? 1000.0/avgMs : 0;
-    double minHz = maxv(portIntervals)>0 ? 1000.0/maxv(portIntervals) : 0;
-    double maxHz = minv(portIntervals)>0 ? 1000.0/minv(portIntervals) : 0;
+void MainWindow::updateCaptions() {
+    if (!mosaic()) return;
+    auto caption = [](const QString &name, const RateStats &rate, const ImageReceiver &r, quint64 dropped) {
+        return QString("%1  %2 Hz  dropped %3, transport %4").arg(name).arg(rate.hz(),0,'f',1)
+               .arg(dropped).arg(r.transportDropped());
+    };
+    imageWidget->setCaption(caption(QString::fromStdString(options.imgInputPortName), receiver.arrivalStats(), receiver,
+                                    receiver.framesDropped() + supersededFrames));
+    for (auto &t : tiles) t->widget->setCaption(caption(t->name, t->receiver->arrivalStats(), *t->receiver, t->receiver->framesDropped()));
+}
+
+void MainWindow::updateStatus() {
+    updateColorbar();
+    updateCaptions();
+    pollFlightTrigger();
+    const ImageReceiver::ConnectionStats cs = receiver.connectionStats();
+    if (inputBytesClock.isValid()) {
+        const double s = inputBytesClock.restart() / 1000.0;
+        if (s > 0.0) inputMBps = 0.7*inputMBps + 0.3*(double(cs.bytes - inputBytes) / s / 1e6);
+    } else {
+        inputBytesClock.start();
+    }
+    inputBytes = cs.bytes;
+    if (!statusBar()->isVisible()) return;
+    if (receiver.isReplaying()) {
+        statusPortName->setText(QString("Replay: %1 (%2/%3)")
+                                .arg(QString::fromStdString(options.replayFile))
+                                .arg(receiver.replayPosition()).arg(receiver.replayLength()));
+    } else {
+        QString text = QString::fromStdString(options.imgInputPortName);
+        if (!cs.source.empty()) {
+            text += QString(" <- %1 ").arg(QString::fromStdString(cs.source));
+            text += cs.connected ? QString("via %1").arg(QString::fromStdString(cs.carrier)) : QString("(not connected)");
+            if (cs.reconnects) text += QString(", %1 reconnects").arg(cs.reconnects);
+        }
+        text += QString("  %1 MB/s").arg(inputMBps,0,'f',1);
+        // Totals per carrier used so far, when the link has changed carrier
+        if (cs.carrierBytes.size() > 1) {
+            QStringList totals;
+            for (const auto &c : cs.carrierBytes) {
+                totals << QString("%1 %2 MB").arg(QString::fromStdString(c.first)).arg(c.second / 1e6,0,'f',1);
+            }
+            text += " (" + totals.join(", ") + ")";
+        }
+        statusPortName->setText(text);
+    }
     int imgW = lastImgW>0? lastImgW:0;
     int imgH = lastImgH>0? lastImgH:0;
-    statusPort->setText(QString("Port: %1 (%2..%3) Hz (size: %4x%5)")
-                        .arg(portHz,0,'f',1).arg(minHz,0,'f',1).arg(maxHz,0,'f',1)
-                        .arg(imgW).arg(imgH));
+    QString conversion = QString("conv %1 ms").arg(receiver.convertMs(),0,'f',2);
+    if (receiver.isCompressedInput()) {
+        const FrameDecoder::Stats ds = receiver.decodeStats();
+        conversion = QString("decode %1 ms x%2, %3 in flight, %4 reordered, %5 failed, %6 busy-dropped")
+                     .arg(ds.decodeMs,0,'f',2).arg(ds.threads).arg(ds.inFlight)
+                     .arg(ds.reordered).arg(ds.failed).arg(ds.dropped);
+    }
+    const ImageReceiver::QueueStats qs = receiver.queueStats();
+    QString queue = QString("%1, %2 waiting (max %3)").arg(ImageReceiver::readPolicyName(qs.policy))
+                    .arg(qs.pending).arg(qs.maxPending);
+    if (qs.policy != ImageReceiver::ReadPolicy::Latest) queue += QString(", %1 skipped").arg(qs.skipped);
+    if (qs.policy == ImageReceiver::ReadPolicy::Auto) queue += QString(" in %1 flushes").arg(qs.flushes);
+    if (qs.policy == ImageReceiver::ReadPolicy::Latest) queue += QString(", %1 overwritten").arg(qs.portDropped);
+    const RateStats portRate = receiver.arrivalStats();
+    statusPort->setText(QString("Port: %1 (%2..%3) Hz, jitter %4 ms (size: %5x%6 %7, %8) dropped: %9, queue: %10")
+                        .arg(portRate.hz(),0,'f',1).arg(portRate.minHz(),0,'f',1).arg(portRate.maxHz(),0,'f',1)
+                        .arg(portRate.jitterMs(),0,'f',1)
+                        .arg(imgW).arg(imgH)
+                        .arg(ImageReceiver::pixelCodeName(receiver.pixelCode()))
+                        .arg(conversion)
+                        .arg(receiver.framesDropped() + supersededFrames)
+                        .arg(queue));
     // Client image area size (central widget / image widget)
     int cw = imageWidget ? imageWidget->width() : 0;
     int ch = imageWidget ? imageWidget->height() : 0;
-    statusDisplay->setText(QString("Display: %1 (%2..%3) Hz (size: %4x%5)")
-                           .arg(dispFps,0,'f',1).arg(minFps,0,'f',1).arg(maxFps,0,'f',1)
-                           .arg(cw).arg(ch));
+    const RateStats &disp = imageWidget->displayStats();
+    statusDisplay->setText(QString("Display: %1 (%2..%3) Hz (size: %4x%5, zoom %6x, scale %7 ms)%8")
+                           .arg(disp.hz(),0,'f',1).arg(disp.minHz(),0,'f',1).arg(disp.maxHz(),0,'f',1)
+                           .arg(cw).arg(ch).arg(imageWidget->zoomFactor(),0,'f',2)
+                           .arg(imageWidget->scaleMs(),0,'f',2)
+                           .arg(options.vsync ? QString(" vsync, missed %1").arg(missedRefreshes) : QString()));
+    // Publish-to-paint when the publisher stamps its frames, else viewer-internal only
+    const LatencyStats::Stage headline = latency.stage(LatencyStats::Total).count() ? LatencyStats::Total : LatencyStats::Render;
+    QString buffer;
+    if (receiver.jitterBufferEnabled()) {
+        const JitterBuffer::Stats js = receiver.jitterStats();
+        buffer = QString(", buffer %1 ms depth %2 underruns %3 overruns %4 late %5 superseded %6")
+                 .arg(js.delayMs,0,'f',0).arg(js.depth).arg(js.underruns).arg(js.overruns).arg(js.late)
+                 .arg(js.superseded);
+    }
+    if (matcher) buffer += ", " + syncSummary();
+    statusLatency->setText(QString("Latency p50/p95/p99/max: %1 %2 ms, transport drops: %3%4")
+                           .arg(LatencyStats::stageName(headline)).arg(latency.summary(headline))
+                           .arg(receiver.transportDropped()).arg(buffer));
+    QString tip("Latency p50/p95/p99/max (ms)");
+    for (int s=0; s<LatencyStats::STAGE_COUNT; ++s) {
+        const auto stage = LatencyStats::Stage(s);
+        tip += QString("\n%1: %2 (%3 frames)").arg(LatencyStats::stageName(stage))
+               .arg(latency.summary(stage)).arg(latency.stage(stage).count());
+    }
+    statusLatency->setToolTip(tip);
+    updateMemoryStatus();
+}
+
+void MainWindow::updateColorbar() {
+    const int code = receiver.pixelCode();
+    if (!colorbarStrip.isNull() && (code==VOCAB_PIXEL_MONO16 || code==VOCAB_PIXEL_MONO_FLOAT)) {
+        double lo, hi;
+        receiver.depthRange(lo, hi);
+        imageWidget->setColorbar(colorbarStrip, lo, hi);
+    } else {
+        imageWidget->setColorbar(QImage(), 0, 0);
+    }
+}
+
+void MainWindow::publishStats() {
+    // One self-describing (key value...) list per metric; the counters are
+    // snapshots the GUI already maintains and the write does not block
+    yarp::os::Bottle &b = statsPort.prepare();
+    b.clear();
+    const RateStats &disp = imageWidget->displayStats();
+    ReceiverStats::addPortRate(b, receiver.arrivalStats());
+    ReceiverStats::addValues(b, "display_hz", {disp.hz(), disp.minHz(), disp.maxHz()});
+    ReceiverStats::addLatency(b, latency, {LatencyStats::Total, LatencyStats::Transport, LatencyStats::Convert,
+                                           LatencyStats::Queue, LatencyStats::Render});
+    ReceiverStats::addReceiver(b, receiver, lastImgW, lastImgH, supersededFrames);
+    if (receiver.jitterBufferEnabled()) {
+        const JitterBuffer::Stats js = receiver.jitterStats();
+        yarp::os::Bottle &l = b.addList();
+        l.addString("jitter_buffer");
+        l.addFloat64(js.delayMs);
+        l.addInt32(js.depth);
+        l.addInt64(qint64(js.underruns));
+        l.addInt64(qint64(js.overruns));
+        l.addInt64(qint64(js.late));
+        l.addInt64(qint64(js.superseded));
+    }
+    if (matcher) {
+        const StampMatcher::Stats s = matcher->stats();
+        yarp::os::Bottle &l = b.addList();
+        l.addString("sync");
+        l.addInt64(qint64(s.pushed));
+        l.addInt64(qint64(s.matched));
+        l.addInt64(qint64(s.unmatched));
+        l.addInt64(qint64(s.superseded));
+        l.addFloat64(s.skew.percentile(0.5));
+        l.addFloat64(s.skew.percentile(0.95));
+        l.addFloat64(s.skew.max());
+    }
+    for (const auto &t : tiles) {
+        yarp::os::Bottle &l = b.addList();
+        l.addString("tile");
+        l.addString(t->name.toStdString());
+        l.addFloat64(t->receiver->arrivalStats().hz());
+        l.addInt64(qint64(t->receiver->framesReceived()));
+        l.addInt64(qint64(t->receiver->framesDropped()));
+        l.addInt64(qint64(t->receiver->transportDropped()));
+        l.addFloat64(t->receiver->convertMs());
+    }
+    if (flight) ReceiverStats::addFlight(b, flight->stats());
+    {
+        const ImageReceiver::ConnectionStats cs = receiver.connectionStats();
+        yarp::os::Bottle &l = b.addList();
+        l.addString("input");
+        l.addString(cs.source.empty() ? std::string("-") : cs.source);
+        l.addString(cs.carrier.empty() ? std::string("-") : cs.carrier);
+        l.addInt32(cs.connected ? 1 : 0);
+        l.addInt64(qint64(cs.reconnects));
+        l.addFloat64(inputMBps);
+        yarp::os::Bottle &per = l.addList();
+        for (const auto &c : cs.carrierBytes) {
+            per.addString(c.first);
+            per.addInt64(qint64(c.second));
+        }
+    }
+    ReceiverStats::addQueue(b, receiver.queueStats());
+    if (relay) ReceiverStats::addRelay(b, relay->stats());
+    if (receiver.isCompressedInput()) {
+        const FrameDecoder::Stats ds = receiver.decodeStats();
+        yarp::os::Bottle &l = b.addList();
+        l.addString("decode");
+        l.addFloat64(ds.decodeMs);
+        l.addInt32(ds.inFlight);
+        l.addInt64(qint64(ds.decoded));
+        l.addInt64(qint64(ds.failed));
+        l.addInt64(qint64(ds.dropped));
+        l.addInt64(qint64(ds.reordered));
+    }
+    ReceiverStats::addValues(b, "convert_ms", {receiver.convertMs()});
+    ReceiverStats::addValues(b, "scale_ms", {imageWidget->scaleMs()});
+    ReceiverStats::addValues(b, "paint_ms", {imageWidget->paintMs()});
+    const FramePool::Stats ps = FramePool::instance().stats();
+    ReceiverStats::addCount(b, "pool_resident_bytes", quint64(ps.residentBytes));
+    ReceiverStats::addCount(b, "pool_free_bytes", quint64(ps.freeBytes));
+    statsPort.write();
+}
+
+void MainWindow::applyDepthSettings(const DepthColormap::Settings &s) {
+    receiver.setDepthSettings(s);
+    for (auto &t : tiles) t->receiver->setDepthSettings(s);
+    if (depthMapGroup) {
+        for (QAction *a : depthMapGroup->actions()) {
+            a->setChecked(s.enabled ? a->data().toInt()==int(s.map) : a->data().toInt()<0);
+        }
+    }
+    if (actDepthAutoRange) actDepthAutoRange->setChecked(s.autoRange);
+    if (s.enabled) {
+        std::uint32_t lut[256];
+        DepthColormap::buildLut(s.map, lut);
+        colorbarStrip = QImage(256, 1, QImage::Format_RGB32);
+        std::memcpy(colorbarStrip.scanLine(0), lut, sizeof(lut));
+    } else {
+        colorbarStrip = QImage();
+        imageWidget->setColorbar(QImage(), 0, 0);
+    }
+}
+
+void MainWindow::setDepthColormap(QAction *act) {
+    DepthColormap::Settings s = receiver.depthSettings();
+    int map = act->data().toInt();
+    s.enabled = map >= 0;
+    if (s.enabled) s.map = DepthColormap::Map(map);
+    applyDepthSettings(s);
+}
+
+void MainWindow::toggleDepthAutoRange() {
+    DepthColormap::Settings s = receiver.depthSettings();
+    s.autoRange = actDepthAutoRange->isChecked();
+    if (!s.autoRange && !(s.farValue > s.nearValue)) {
+        // No fixed range yet: freeze the one auto range was using
+        double lo, hi;
+        receiver.depthRange(lo, hi);
+        s.nearValue = float(lo);
+        s.farValue = float(hi);
+    }
+    applyDepthSettings(s);
+}
+
+void MainWindow::changeDepthRange() {
+    DepthColormap::Settings s = receiver.depthSettings();
+    double lo = s.nearValue, hi = s.farValue;
+    if (s.autoRange || !(hi > lo)) receiver.depthRange(lo, hi);
+    bool ok = false;
+    double n = QInputDialog::getDouble(this, "Depth Range", "Near (image units):", lo, -1e9, 1e9, 3, &ok);
+    if (!ok) return;
+    double f = QInputDialog::getDouble(this, "Depth Range", "Far (image units):", hi, -1e9, 1e9, 3, &ok);
+    if (!ok) return;
+    if (!(f > n)) { QMessageBox::warning(this, "Depth Range", "Far must be greater than near."); return; }
+    s.nearValue = float(n);
+    s.farValue = float(f);
+    s.autoRange = false;
+    applyDepthSettings(s);
+}
+
+void MainWindow::updateMemoryStatus() {
+    if (statusRecord->isVisible()) {
+        QStringList parts;
+        if (recorder.isRecording() || recorder.stats().queued > 0) {
+            ImageRecorder::Stats rs = recorder.stats();
+            parts << QString("Rec: %1 queued, %2 written, %3 dropped%4")
+                     .arg(rs.queued).arg(rs.written).arg(rs.dropped)
+                     .arg(rs.failed ? QString(", %1 failed").arg(rs.failed) : QString());
+        }
+        if (receiver.isRecording()) {
+            const FrameFile::QueuedWriter::Stats ss = receiver.recordingStats();
+            parts << QString("Stream: %1 frames, %2 MB, %3 queued, %4 dropped")
+                     .arg(ss.frames).arg(ss.bytes/1048576.0,0,'f',1).arg(ss.queued).arg(ss.dropped);
+        }
+        if (flight) {
+            const FlightRecorder::Stats fs = flight->stats();
+            parts << QString("Flight: %1 frames, %2 s, %3 MB (raw %4 MB), %5 dumps%6%7")
+                     .arg(fs.frames).arg(fs.seconds,0,'f',1)
+                     .arg(fs.bytes/1048576.0,0,'f',1).arg(fs.rawBytes/1048576.0,0,'f',1)
+                     .arg(fs.dumps)
+                     .arg(fs.dumpFailed ? QString(", %1 failed").arg(fs.dumpFailed) : QString())
+                     .arg(fs.dumping ? QString(", writing") : QString());
+            if (flightIndex >= 0) parts << QString("Step: %1/%2").arg(flightIndex + 1).arg(fs.frames);
+        }
+        if (relay) {
+            const StreamRelay::Stats os = relay->stats();
+            parts << QString("Out: %1x%2, %3 sent, %4 MB, %5 rate-skipped, %6 busy-skipped, %7 ms")
+                     .arg(os.size.width()).arg(os.size.height()).arg(os.published)
+                     .arg(os.bytes/1048576.0,0,'f',1).arg(os.decimated).arg(os.superseded)
+                     .arg(os.workMs,0,'f',2);
+        }
+        statusRecord->setText(parts.isEmpty() ? QString("Rec: -") : parts.join("  "));
+    }
+    FramePool::Stats ps = FramePool::instance().stats();
+    statusMemory->setText(QString("Pool: hit %1 miss %2 (resident %3 MB, free %4 MB)")
+                          .arg(ps.hits).arg(ps.misses)
+                          .arg(ps.residentBytes/1048576.0,0,'f',1)
+                          .arg(ps.freeBytes/1048576.0,0,'f',1));
 }
 
 void MainWindow::saveSingleImage() {
@@ -254,14 +916,35 @@ void MainWindow::saveSingleImage() {
     if (hasBufferedImage) bufferedImage.save(fn);
 }
 void MainWindow::saveImageSet() {
-    if (!savingImageSet) {
+    if (!recorder.isRecording()) {
         QString dir = QFileDialog::getExistingDirectory(this, "Select Directory for Image Set");
-        if (dir.isEmpty()) return; imageSetDirectory = dir; imageSetCounter=0; savingImageSet=true; actSaveSet->setText("Stop saving image set");
-    } else { savingImageSet=false; actSaveSet->setText("Save a set of images"); }
+        if (dir.isEmpty()) return;
+        ImageRecorder::Settings s;
+        if (!ImageRecorder::formatFromName(QString::fromStdString(options.recFormat), s.format)) {
+            yWarning() << "Unknown image set format" << options.recFormat << "- using png";
+        }
+        s.quality = options.recQuality;
+        s.threads = options.recThreads;
+        s.queueDepth = options.recQueue;
+        if (!recorder.start(dir, s)) { QMessageBox::warning(this, "Save a set of images", "Cannot write to " + dir); return; }
+        actSaveSet->setText("Stop saving image set");
+        statusRecord->setVisible(true);
+    } else { recorder.stop(); actSaveSet->setText("Save a set of images"); }
+    updateIngestSize();
+}
+
+void MainWindow::toggleStreamRecording() {
+    if (!receiver.isRecording()) {
+        QString fn = QFileDialog::getSaveFileName(this, "Record Stream", QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")+".yvf", "Frame recordings (*.yvf)");
+        if (fn.isEmpty()) return;
+        if (!receiver.startRecording(fn)) { QMessageBox::warning(this, "Record stream", "Cannot write " + fn); return; }
+        actRecordStream->setText("Stop recording stream");
+        statusRecord->setVisible(true);
+    } else { receiver.stopRecording(); actRecordStream->setText("Record stream..."); }
 }
 
-void MainWindow::originalSize() { currentMode = DisplayMode::OriginalSize; actOriginalAspect->setChecked(false); displayTick(); }
-void MainWindow::originalAspectRatio() { currentMode = DisplayMode::AspectRatio; actOriginalSize->setChecked(false); if (lastImgW>0&& lastImgH>0) aspectRatio = double(lastImgH)/double(lastImgW); displayTick(); }
+void MainWindow::originalSize() { currentMode = DisplayMode::OriginalSize; actOriginalAspect->setChecked(false); updateDisplayMode(true); }
+void MainWindow::originalAspectRatio() { currentMode = DisplayMode::AspectRatio; actOriginalSize->setChecked(false); if (lastImgW>0&& lastImgH>0) aspectRatio = double(lastImgH)/double(lastImgW); updateDisplayMode(true); }
 
 // New helper functions to allow reversible size behavior
 void MainWindow::applyStretchMode() {
@@ -269,6 +952,7 @@ void MainWindow::applyStretchMode() {
     actOriginalSize->setChecked(false);
     actOriginalAspect->setChecked(false);
     imageWidget->setMode(DisplayMode::StretchToWindow);
+    for (auto &t : tiles) t->widget->setMode(DisplayMode::StretchToWindow);
     imageWidget->update();
 }
 void MainWindow::applyOriginalSizeMode() {
@@ -276,7 +960,9 @@ void MainWindow::applyOriginalSizeMode() {
     actOriginalSize->setChecked(true);
     actOriginalAspect->setChecked(false);
     imageWidget->setMode(DisplayMode::OriginalSize);
-    if (hasBufferedImage) setClientImageSize(bufferedImage.width(), bufferedImage.height());
+    for (auto &t : tiles) t->widget->setMode(DisplayMode::OriginalSize);
+    // A mosaic window is sized by the user, never by one of its streams
+    if (hasBufferedImage && !mosaic()) setClientImageSize(bufferedFullSize.width(), bufferedFullSize.height());
     imageWidget->update();
 }
 void MainWindow::applyAspectRatioMode() {
@@ -284,24 +970,56 @@ void MainWindow::applyAspectRatioMode() {
     actOriginalAspect->setChecked(true);
     actOriginalSize->setChecked(false);
     imageWidget->setMode(DisplayMode::AspectRatio);
+    for (auto &t : tiles) t->widget->setMode(DisplayMode::AspectRatio);
     // Force window client area aspect to match image aspect while keeping current width (or height if width unavailable)
-    if (hasBufferedImage && currentImageAspect>0.0) {
+    if (hasBufferedImage && currentImageAspect>0.0 && !mosaic()) {
         // Choose a target based on current client width
         int clientW = imageWidget->width();
-        if (clientW <= 0) clientW = bufferedImage.width();
+        if (clientW <= 0) clientW = bufferedFullSize.width();
         int targetH = int(std::round(clientW * currentImageAspect));
         // Adjust client size exactly
         setClientImageSize(clientW, targetH);
     }
     imageWidget->update();
 }
-void MainWindow::toggleFreeze() { bool frz=!receiver.isFrozen(); receiver.setFrozen(frz); actFreeze->setChecked(frz); actFreeze->setText(frz?"Unfreeze":"Freeze"); }
-void MainWindow::toggleSynch() { options.synch=!options.synch; actSynch->setChecked(options.synch); if (options.synch){ if (displayTimer) displayTimer->stop(); displayTick(); } else { if (!displayTimer){ displayTimer=new QTimer(this); connect(displayTimer,&QTimer::timeout,this,&MainWindow::displayTick);} displayTimer->setInterval(options.refreshMs); displayTimer->start(); } }
-void MainWindow::toggleAutoResize() { options.autosize=!options.autosize; actAutoResize->setChecked(options.autosize); if (options.autosize) currentMode=DisplayMode::OriginalSize; displayTick(); }
+void MainWindow::toggleFreeze() {
+    bool frz=!receiver.isFrozen(); receiver.setFrozen(frz); for (auto &t : tiles) t->receiver->setFrozen(frz); actFreeze->setChecked(frz); actFreeze->setText(frz?"Unfreeze":"Freeze");
+    // Frozen, the flight recorder ring can be stepped through; live again, the next frame takes over
+    flightIndex = -1;
+    actStepBack->setEnabled(frz && flight);
+    actStepForward->setEnabled(frz && flight);
+}
+void MainWindow::toggleSynch() { setPresentationMode(!options.synch, false); }
+void MainWindow::toggleVsync() { setPresentationMode(false, !options.vsync); }
+void MainWindow::setPresentationMode(bool synch, bool vsync) {
+    // Three exclusive schedulers: fixed timer (default), per frame (synch), per screen refresh (vsync)
+    options.synch = synch;
+    options.vsync = vsync;
+    actSynch->setChecked(synch);
+    actVsync->setChecked(vsync);
+    imageWidget->setPresentOnRequest(vsync);
+    for (auto &t : tiles) t->widget->setPresentOnRequest(vsync);
+    if (synch || vsync) {
+        if (displayTimer) displayTimer->stop();
+        if (synch) pullFrame(); else displayTick();
+    } else {
+        if (!displayTimer){ displayTimer=new QTimer(this); connect(displayTimer,&QTimer::timeout,this,&MainWindow::displayTick);}
+        displayTimer->setInterval(options.refreshMs);
+        displayTimer->start();
+    }
+}
+void MainWindow::toggleAutoResize() { options.autosize=!options.autosize; actAutoResize->setChecked(options.autosize); if (options.autosize) currentMode=DisplayMode::OriginalSize; updateDisplayMode(true); }
+void MainWindow::setScaling(QAction *act) {
+    ScaleKernels::Kernel k = ScaleKernels::Kernel(act->data().toInt());
+    options.scaling = ScaleKernels::kernelName(k);
+    imageWidget->setScaleKernel(k);
+    for (auto &t : tiles) t->widget->setScaleKernel(k);
+}
 void MainWindow::toggleDisplayPixelValue() { 
     bool vis = actDisplayPixelValue->isChecked();
     statusPixelValue->setVisible(vis);
     if (statusPixelPatch) statusPixelPatch->setVisible(vis);
+    updateIngestSize();
 }
 void MainWindow::toggleKeepAbove() {
     bool want = actKeepAbove->isChecked();
@@ -323,20 +1041,42 @@ void MainWindow::toggleKeepAbove() {
 }
 // Ensure patch toggles with label
 // (placed after function definition for brevity)
-void MainWindow::changeRefreshInterval() { bool ok=false; int v=QInputDialog::getInt(this,"Change Refresh Interval","Refresh period (ms):",options.refreshMs,1,10000,1,&ok); if (ok){ options.refreshMs=v; if (!options.synch && displayTimer) displayTimer->setInterval(v);} }
+void MainWindow::changeRefreshInterval() { bool ok=false; int v=QInputDialog::getInt(this,"Change Refresh Interval","Refresh period (ms):",options.refreshMs,1,10000,1,&ok); if (ok){ options.refreshMs=v; if (displayTimer) displayTimer->setInterval(v);} }
 void MainWindow::showAbout() { QMessageBox::about(this, "About yarpview-qt6", "yarpview-qt6\nQt6 Widgets YARP image viewer"); }
 
 void MainWindow::displayTick() {
+    Trace::Scope trace("displayTick");
+    // In synch mode onImage() already presents every pulled frame
+    if (!options.synch) pullFrame();
+    // Nothing new since the last presented frame: leave the widget alone
+    if (!hasBufferedImage || frameGeneration == presentedGeneration) return;
+    presentedGeneration = frameGeneration;
+    updateDisplayMode(false);
+    imageWidget->setSourceImage(bufferedImage, bufferedFullSize);
+    // Matched tiles are handed over in the same event as the main frame
+    for (size_t i=0; i<matchedTileFrames.size() && i<tiles.size(); ++i) {
+        tiles[i]->widget->setSourceImage(matchedTileFrames[i].image, matchedTileFrames[i].fullSize);
+    }
+    matchedTileFrames.clear();
+}
+
+void MainWindow::updateDisplayMode(bool force) {
     if (!hasBufferedImage) return;
     // Determine effective mode based on actions (reversible logic)
-    if (actOriginalSize->isChecked()) {
+    const DisplayMode want = actOriginalSize->isChecked() ? DisplayMode::OriginalSize
+                           : actOriginalAspect->isChecked() ? DisplayMode::AspectRatio
+                           : DisplayMode::StretchToWindow;
+    // Geometry only needs re-applying when the mode or the image size changes
+    if (!force && want == appliedMode && bufferedFullSize == appliedImageSize) return;
+    appliedMode = want;
+    appliedImageSize = bufferedFullSize;
+    if (want == DisplayMode::OriginalSize) {
         applyOriginalSizeMode();
-    } else if (actOriginalAspect->isChecked()) {
+    } else if (want == DisplayMode::AspectRatio) {
         applyAspectRatioMode();
     } else {
         applyStretchMode();
     }
-    imageWidget->setSourceImage(bufferedImage);
 }
 
 void MainWindow::setClientImageSize(int w,int h){ if (!centralWidget()) return; int frameW=width()-centralWidget()->width(); int frameH=height()-centralWidget()->height(); frameW=std::max(frameW,0); frameH=std::max(frameH,0); resize(w+frameW,h+frameH); }
@@ -344,7 +1084,7 @@ void MainWindow::setClientImageSize(int w,int h){ if (!centralWidget()) return;
 void MainWindow::resizeEvent(QResizeEvent *e){ 
     QMainWindow::resizeEvent(e);
     if (!hasBufferedImage) return;
-    if (currentMode==DisplayMode::AspectRatio && currentImageAspect>0.0) {
+    if (currentMode==DisplayMode::AspectRatio && currentImageAspect>0.0 && !mosaic()) {
         // Enforce aspect after user resize: keep width, adjust height
         int clientW = imageWidget->width();
         int desiredH = int(std::round(clientW * currentImageAspect));
@@ -363,4 +1103,13 @@ void MainWindow::keyPressEvent(QKeyEvent *e) {
     QMainWindow::keyPressEvent(e);
 }
 
-void MainWindow::showEvent(QShowEvent *e) { QMainWindow::showEvent(e); }
+void MainWindow::showEvent(QShowEvent *e) {
+    QMainWindow::showEvent(e);
+    // The native window is (re)created on show, e.g. after a window flag change
+    if (windowHandle() && windowHandle() != filteredWindow) {
+        filteredWindow = windowHandle();
+        filteredWindow->installEventFilter(this);
+        refreshPending = false;
+        if (options.vsync) scheduleRefresh();
+    }
+}
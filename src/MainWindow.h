@@ -5,12 +5,21 @@
 #include <QElapsedTimer>
 #include <QKeyEvent>
 #include <QShowEvent>
+#include <QActionGroup>
+#include <QPointer>
+#include <QWindow>
 #include <deque>
+#include <memory>
+#include <vector>
 #include <yarp/os/BufferedPort.h>
 #include <yarp/os/Bottle.h>
 #include "Options.h"
 #include "ImageReceiver.h"
 #include "ImageWidget.h"
+#include "ImageRecorder.h"
+#include "LatencyStats.h"
+#include "RateStats.h"
+#include "StampMatcher.h"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -19,14 +28,19 @@ public:
     ~MainWindow() override;
 
 private slots:
-    void onImage(const QImage &img, const yarp::os::Stamp &stamp);
+    void onFrameAvailable();
+    void onImage(const QImage &img, const QSize &fullSize, const yarp::os::Stamp &stamp);
     void onLeftClick(int x,int y);
     void onRightClick(int x,int y);
-    void updateDisplayFps(double dispFps, double minFps, double maxFps);
+    void updateStatus();
+    void onFramePainted(qint64 key);
+    void resetLatencyStats();
     
     // File menu
     void saveSingleImage();
     void saveImageSet();
+    void toggleStreamRecording();
+    void dumpFlightRecorder();
     
     // Image menu
     void originalSize();
@@ -35,61 +49,159 @@ private slots:
     void applyOriginalSizeMode();
     void applyAspectRatioMode();
     void toggleFreeze();
+    void stepBack() { stepFlight(-1); }
+    void stepForward() { stepFlight(+1); }
     void toggleSynch();
+    void toggleVsync();
+    void serviceJitterBuffer(); // a buffered frame may be due
     void toggleAutoResize();
     void toggleDisplayPixelValue();
+    void setScaling(QAction *act);
     void changeRefreshInterval();
     void toggleKeepAbove(); // newly added
+    void setDepthColormap(QAction *act);
+    void toggleDepthAutoRange();
+    void changeDepthRange();
     
     // Help menu
     void showAbout();
 
+    // Telemetry (--stats)
+    void publishStats();
+
     // Display timer tick (asynchronous refresh)
     void displayTick();
     void setClientImageSize(int w, int h); // resize outer window so central image area matches (w,h)
+    void updateDisplayMode(bool force); // apply the checked mode if it or the image size changed
 
 private:
     void buildUi();
     void createMenus();
     void openPorts();
+    void updateMemoryStatus();
+    void updateColorbar(); // legend follows the receiver's depth range
+    void applyDepthSettings(const DepthColormap::Settings &s);
+    bool pullFrame(); // take the newest frame from the receiver mailbox, if any
+    // Ingest reduction of the main stream: off while a full-resolution
+    // consumer is active (image set recording, pixel value readout)
+    void updateIngestSize();
 
     YarpViewOptions options;
     ImageReceiver receiver;
     ImageWidget *imageWidget{nullptr};
 
+    // Mosaic (--input): further streams, each with its own receiver and
+    // widget in a grid next to the main one. Tiles show frames on arrival,
+    // get them reduced to their on-screen size at ingest, and share the
+    // widgets' render threads. Clicks, recording and latency stay with the
+    // main stream.
+    struct Tile {
+        QString name;
+        std::unique_ptr<ImageReceiver> receiver;
+        ImageWidget *widget{nullptr};
+    };
+    std::vector<std::unique_ptr<Tile>> tiles;
+    bool mosaic() const { return !tiles.empty(); }
+    void openTiles();
+    void updateCaptions();
+
+    // Synchronized view (--sync-tolerance): all inputs feed one matcher and only
+    // complete sets are shown, the tiles together with the main frame
+    std::unique_ptr<StampMatcher> matcher;
+    std::vector<FrameMailbox::Frame> matchedTileFrames; // waiting for the main frame's presentation
+    bool takeMatchedSet(FrameMailbox::Frame &main);
+    QString syncSummary() const;
+
     yarp::os::BufferedPort<yarp::os::Bottle> leftClickPort;  // opened only if options.leftClickEnabled
     yarp::os::BufferedPort<yarp::os::Bottle> rightClickPort; // opened only if options.rightClickEnabled
+    yarp::os::BufferedPort<yarp::os::Bottle> statsPort;      // opened only if options.statsEnabled
+    yarp::os::BufferedPort<yarp::os::Bottle> flightPort;     // dump trigger, opened only with --flight
+    QTimer *statsTimer{nullptr};
 
     QLabel *statusPortName{nullptr};
     QLabel *statusPort{nullptr};
     QLabel *statusDisplay{nullptr};
+    QLabel *statusLatency{nullptr};
+    QLabel *statusMemory{nullptr};
+    QLabel *statusRecord{nullptr};
     QLabel *statusPixelValue{nullptr};
     QLabel *statusPixelPatch{nullptr};
 
     // Menu actions
     QAction *actSaveSingle{nullptr};
     QAction *actSaveSet{nullptr};
+    QAction *actRecordStream{nullptr};
     QAction *actOriginalSize{nullptr};
     QAction *actOriginalAspect{nullptr};
+    QAction *actResetZoom{nullptr};
     QAction *actFreeze{nullptr};
+    QAction *actFlightDump{nullptr};
+    QAction *actStepBack{nullptr};
+    QAction *actStepForward{nullptr};
     QAction *actSynch{nullptr};
+    QAction *actVsync{nullptr};
     QAction *actAutoResize{nullptr};
     QAction *actDisplayPixelValue{nullptr};
+    QActionGroup *scalingGroup{nullptr}; // Nearest / Bilinear / Area
     QAction *actChangeRefresh{nullptr};
     QAction *actKeepAbove{nullptr}; // new action
+    QActionGroup *depthMapGroup{nullptr}; // Off / Gray / Jet / Turbo
+    QAction *actDepthAutoRange{nullptr};
+    QImage colorbarStrip; // LUT of the active depth colormap
     
-    // Image set saving state
-    bool savingImageSet{false};
-    QString imageSetDirectory;
-    int imageSetCounter{0};
+    // Image set saving (encoded off the GUI thread)
+    ImageRecorder recorder;
+
+    // Flight recorder (--flight): pre-roll of the main stream, dumped on F9
+    // or a message on the trigger port; while frozen, stepped through
+    std::unique_ptr<FlightRecorder> flight;
+    int flightIndex{-1}; // ring frame shown while frozen, -1: the live frame
+    // Re-publish output (--out): reduced copy of the main stream on <basename>/out:o
+    std::unique_ptr<StreamRelay> relay;
+    void dumpFlightRecorderTo(const QString &fileName);
+    void pollFlightTrigger();
+    void stepFlight(int delta);
+
+    // Frame latency: stage times of frames taken from the receiver, kept
+    // until the widget reports their first paint
+    LatencyStats latency;
+    struct PendingPaint {
+        qint64 key{0};
+        double stampTime{0.0}; // 0: no usable publisher stamp
+        double takenTime{0.0};
+        int seq{-1}; // envelope sequence number, for tracing
+    };
+    std::deque<PendingPaint> pendingPaints;
+    static constexpr int MAX_PENDING_PAINTS = 8;
+
+    // Refresh-driven presentation (--vsync): frames are rendered on arrival,
+    // finished renders between two screen refreshes are coalesced into one
+    // QWindow::requestUpdate() and installed in the widgets on UpdateRequest
+    void scheduleRefresh();
+    void setPresentationMode(bool synch, bool vsync);
+    QPointer<QWindow> filteredWindow;
+    bool refreshPending{false};
+    QElapsedTimer refreshRequested;
+    quint64 missedRefreshes{0}; // painted after the refresh following the one it was taken in
+    QTimer *jitterTimer{nullptr}; // single shot at the next buffered frame's due time
 
     // Asynchronous display buffering
     QTimer *displayTimer{nullptr};
     QImage bufferedImage;
+    QSize bufferedFullSize; // stream resolution of bufferedImage (larger when reduced at ingest)
     bool hasBufferedImage{false};
-    QElapsedTimer portTimer; // arrival intervals
-    std::deque<double> portIntervals;
-    static constexpr int PORT_WINDOW = 120;
+    quint64 frameGeneration{0};     // bumped for every frame taken from the receiver
+    quint64 presentedGeneration{0}; // last generation handed to the widget
+    quint64 supersededFrames{0};    // taken but replaced before being presented, counted as dropped
+    DisplayMode appliedMode{DisplayMode::StretchToWindow};
+    QSize appliedImageSize;         // image size the mode geometry was applied for
+    ImageReceiver::ReadPolicy readPolicy{ImageReceiver::ReadPolicy::Latest};
+    // Input throughput, sampled by updateStatus
+    quint64 inputBytes{0};
+    QElapsedTimer inputBytesClock;
+    double inputMBps{0.0};
+    QTimer *statusTimer{nullptr};
+    static constexpr int STATUS_PERIOD_MS = 250;
     DisplayMode currentMode{DisplayMode::StretchToWindow};
     double aspectRatio{0.0};
     int lastImgW{-1};
@@ -101,4 +213,5 @@ protected:
     void resizeEvent(QResizeEvent *e) override;
     void keyPressEvent(QKeyEvent *e) override;
     void showEvent(QShowEvent *e) override;
+    bool eventFilter(QObject *obj, QEvent *ev) override;
 };
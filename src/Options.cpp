@@ -1,6 +1,8 @@
 #include "Options.h"
 #include <yarp/os/Value.h>
 #include <yarp/os/LogStream.h>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 void OptionsParser::fillResourceFinderDefaults(yarp::os::ResourceFinder &rf) {
@@ -25,6 +27,10 @@ YarpViewOptions OptionsParser::parse(int &argc, char **argv, yarp::os::ResourceF
 
     std::string baseName = rf.check("name", yarp::os::Value("/yarpview-qt6")).asString();
     opt.imgInputPortName = baseName; // image input port (user supplies full name)
+    // The ResourceFinder keeps one value per key: collect repeated --input from argv
+    for (int i=1; i+1<argc; ++i) {
+        if (std::strcmp(argv[i], "--input") == 0) opt.mosaicInputs.push_back(argv[++i]);
+    }
 
     // Optional click output ports: flags only. When flag present, construct default port name.
     if (rf.check("leftClick")) {
@@ -36,13 +42,76 @@ YarpViewOptions OptionsParser::parse(int &argc, char **argv, yarp::os::ResourceF
         opt.rightClickOutPortName = baseName + "/right:click";
     }
 
+    if (rf.check("stats")) {
+        opt.statsEnabled = true;
+        opt.statsOutPortName = baseName + "/stats:o";
+    }
+    if (rf.check("stats-period")) opt.statsPeriodMs = std::max(100, rf.find("stats-period").asInt32());
+
     opt.autosize = rf.check("autosize");
     opt.synch = rf.check("synch");
+    opt.vsync = rf.check("vsync");
+    if (opt.vsync) opt.synch = false;
+    if (rf.check("jitter-buffer")) opt.jitterDelayMs = std::max(0.0, rf.find("jitter-buffer").asFloat64());
+    if (rf.check("sync-tolerance")) {
+        const yarp::os::Value &v = rf.find("sync-tolerance");
+        opt.syncToleranceMs = v.isNull() ? 0.0 : v.asFloat64();
+        if (!(opt.syncToleranceMs > 0.0)) opt.error = "--sync-tolerance needs a tolerance in ms greater than 0";
+    }
+    // One letter away from --synch: refused rather than read as something else
+    if (rf.check("sync")) opt.error = "--sync is not an option: --sync-tolerance <ms> matches stamps, --synch updates on new images";
+    if (rf.check("sync-queue")) opt.syncQueue = std::max(1, rf.find("sync-queue").asInt32());
+    opt.compressedInput = rf.check("compressed");
+    if (rf.check("decode-threads")) opt.decodeThreads = std::max(1, rf.find("decode-threads").asInt32());
+    if (rf.check("connect")) opt.connectSource = rf.find("connect").asString();
+    if (rf.check("carrier")) opt.carrier = rf.find("carrier").asString();
+    if (rf.check("policy")) opt.readPolicy = rf.find("policy").asString();
+    if (rf.check("queue")) opt.queueDepth = std::max(1, rf.find("queue").asInt32());
+    opt.headless = rf.check("headless");
+    if (rf.check("out")) {
+        opt.relayEnabled = true;
+        opt.relayOutPortName = baseName + "/out:o";
+    }
+    if (rf.check("out-scale")) opt.relayScale = std::clamp(rf.find("out-scale").asFloat64(), 0.01, 1.0);
+    if (rf.check("out-rate")) opt.relayRate = std::max(0.0, rf.find("out-rate").asFloat64());
+    if (rf.check("out-jpeg")) opt.relayJpegQuality = std::clamp(rf.find("out-jpeg").asInt32(), 0, 100);
     opt.compact = rf.check("compact");
     opt.minimal = rf.check("minimal");
     opt.keepAbove = rf.check("keep-above");
+    if (rf.check("smooth")) opt.scaling = "area";
+    if (rf.check("scaling")) opt.scaling = rf.find("scaling").asString();
     opt.saveOptions = rf.check("saveoptions") || rf.check("SaveOptions");
 
+    if (rf.check("colormap")) opt.colormap = rf.find("colormap").asString();
+    opt.depth = rf.check("depth") || rf.check("colormap");
+    if (rf.check("near") && rf.check("far")) {
+        opt.depthNear = rf.find("near").asFloat64();
+        opt.depthFar = rf.find("far").asFloat64();
+        opt.depthAutoRange = false;
+        if (!(opt.depthFar > opt.depthNear)) opt.error = "--far must be greater than --near";
+    } else if (rf.check("near") || rf.check("far")) {
+        opt.error = "--near and --far set a fixed depth range together; give both (or neither for auto range)";
+    }
+    if (rf.check("autorange")) opt.depthAutoRange = true;
+
+    if (rf.check("rec-format")) opt.recFormat = rf.find("rec-format").asString();
+    if (rf.check("rec-quality")) opt.recQuality = rf.find("rec-quality").asInt32();
+    if (rf.check("rec-threads")) opt.recThreads = rf.find("rec-threads").asInt32();
+    if (rf.check("rec-queue")) opt.recQueue = rf.find("rec-queue").asInt32();
+
+    if (rf.check("record")) opt.recordFile = rf.find("record").asString();
+    if (rf.check("replay")) opt.replayFile = rf.find("replay").asString();
+    if (rf.check("replay-speed")) opt.replaySpeed = rf.find("replay-speed").asFloat64();
+    opt.replayLoop = rf.check("replay-loop");
+    if (rf.check("flight")) {
+        opt.flightSeconds = std::max(0.0, rf.find("flight").asFloat64());
+        opt.flightTriggerPortName = baseName + "/flight:i";
+    }
+    if (rf.check("flight-mb")) opt.flightMB = std::max(1, rf.find("flight-mb").asInt32());
+    opt.flightCompress = rf.check("flight-compress");
+    if (rf.check("flight-dir")) opt.flightDir = rf.find("flight-dir").asString();
+    if (rf.check("trace")) opt.traceFile = rf.find("trace").asString();
+
     if (rf.check("p")) opt.refreshMs = rf.find("p").asInt32();
     if (rf.check("refresh")) opt.refreshMs = rf.find("refresh").asInt32();
 
@@ -66,15 +135,52 @@ void OptionsParser::printHelp() {
         {"--help",                "Show this help and exit"},
         {"--name <basename>",    "Base name (default /yarpview-qt6)"},
         {"--title <title>",      "Window title"},
+        {"--input <port>",       "Open another input port as a mosaic tile (repeatable)"},
         {"--leftClick",          "Enable left-click output port (<basename>/left:click)"},
         {"--rightClick",         "Enable right-click output port (<basename>/right:click)"},
+        {"--stats",              "Publish performance telemetry on <basename>/stats:o"},
+        {"--stats-period <ms>",  "Telemetry period (default 1000, min 100)"},
         {"--autosize",           "Auto-resize window client area to image size"},
         {"--synch",              "Synchronous display (update only on new image)"},
+        {"--vsync",              "Present the newest frame on each screen refresh (overrides --synch/--p)"},
+        {"--jitter-buffer <ms>", "Smooth bursty streams: present frames at their stamp times plus this delay"},
+        {"--sync-tolerance <ms>", "With --input: show only frames whose stamps match within this tolerance"},
+        {"--sync-queue <n>",     "Frames kept per input while waiting for a match (default 8)"},
+        {"--compressed",         "Input ports carry encoded images (JPEG/PNG blob in a Bottle)"},
+        {"--decode-threads <n>", "Decoder threads per input for --compressed (default 3)"},
+        {"--connect <port>",     "Connect this source port to the input at startup and reconnect if it drops"},
+        {"--carrier <name>",     "Carrier for --connect: auto (default: shmem if local, else tcp), shmem, fast_tcp, udp, tcp, ..."},
+        {"--policy <p>",         "Input queue: latest (default, newest frame only), strict (every frame), auto (strict, flush backlogs)"},
+        {"--queue <n>",          "Frames allowed to wait in the port with strict/auto (default 8)"},
         {"--p <ms>",             "Refresh period ms (alias: --refresh)"},
         {"--refresh <ms>",       "Same as --p <ms> (default 30)"},
+        {"--depth",              "Colormap mono16/float (depth) images"},
+        {"--colormap <map>",     "Depth colormap: gray, jet (default), turbo; implies --depth"},
+        {"--near <v> --far <v>", "Fixed depth range in image units (default: auto range)"},
+        {"--autorange",          "Track depth range from running min/max"},
+        {"--rec-format <fmt>",   "Image set format: png (default), jpg, ppm, raw"},
+        {"--rec-quality <n>",    "PNG compression level 0-9 or JPEG quality 0-100"},
+        {"--rec-threads <n>",    "Image set encoder threads (default 2)"},
+        {"--rec-queue <n>",      "Frames queued for encoding before dropping (default 16)"},
+        {"--record <file>",      "Record the incoming stream (native pixels + stamps) to a file"},
+        {"--replay <file>",      "Play a recorded stream instead of reading the port"},
+        {"--replay-speed <x>",   "Playback speed factor (default 1, 0 = as fast as possible)"},
+        {"--replay-loop",        "Restart playback at the end of the file"},
+        {"--flight <s>",         "Keep the last s seconds of frames in memory; dump with F9 or <basename>/flight:i"},
+        {"--flight-mb <n>",      "Flight recorder memory budget (default 256)"},
+        {"--flight-compress",    "Compress flight recorder frames in the background (zlib)"},
+        {"--flight-dir <dir>",   "Directory for flight recorder dumps (default: current)"},
+        {"--out",                "Re-publish the stream on <basename>/out:o for remote viewers"},
+        {"--out-scale <f>",      "Scale of the re-published frames (default 0.5)"},
+        {"--out-rate <hz>",      "Maximum re-publish rate (default: every frame)"},
+        {"--out-jpeg <q>",       "Re-publish JPEG at quality q (read with --compressed) instead of raw RGB/mono"},
+        {"--trace <file.json>",  "Record a pipeline trace (Chrome/Perfetto JSON, written on exit)"},
+        {"--headless",           "Run yarpview-qt6-headless: no window, receive, record, flight recorder and stats:o only"},
         {"--compact",            "Hide menu and status bar"},
         {"--minimal",            "Hide chrome (frameless) and UI elements"},
         {"--keep-above",         "Start with window always on top"},
+        {"--scaling <kernel>",   "Display scaling: nearest (default), bilinear, area"},
+        {"--smooth",             "Same as --scaling area"},
     {"--w <px>",             "Initial window width (alias: --width)"},
     {"--width <px>",         "Same as --w"},
     {"--h <px>",             "Initial window height (alias: --height)"},
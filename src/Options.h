@@ -1,24 +1,70 @@
 #pragma once
 #include <QString>
 #include <string>
+#include <vector>
 #include <yarp/os/Property.h>
 #include <yarp/os/ResourceFinder.h>
 
 struct YarpViewOptions {
     QString windowTitle;
     std::string imgInputPortName;      // image input port name (defaults to --name value)
+    std::vector<std::string> mosaicInputs; // --input (repeatable): extra input ports shown as mosaic tiles
     std::string leftClickOutPortName;  // <basename>/left:click when --leftClick flag present
     std::string rightClickOutPortName; // <basename>/right:click when --rightClick flag present
     bool leftClickEnabled = false;     // true if --leftClick flag supplied
     bool rightClickEnabled = false;    // true if --rightClick flag supplied
+    std::string statsOutPortName;      // <basename>/stats:o when --stats flag present
+    bool statsEnabled = false;
+    int statsPeriodMs = 1000;          // --stats-period
     bool autosize = false;
     bool synch = false; // synchronous display
+    bool vsync = false; // present the newest frame on the next screen refresh (--vsync)
+    double jitterDelayMs = 0.0; // --jitter-buffer: playout delay, 0 = off (latest frame wins)
+    double syncToleranceMs = 0.0; // --sync-tolerance: show only stamp-matched sets of all inputs, 0 = off
+    int syncQueue = 8;            // --sync-queue: frames kept per input while waiting for partners
+    bool compressedInput = false; // --compressed: ports carry encoded images (blob in a Bottle)
+    int decodeThreads = 3;        // --decode-threads
+    std::string connectSource;    // --connect: source port connected (and reconnected) to the input
+    std::string carrier = "auto"; // --carrier: auto = shmem for a source on this host, else tcp
+    std::string readPolicy = "latest"; // --policy: latest, strict, auto
+    int queueDepth = 8;                // --queue: waiting frames allowed by strict/auto
+    bool headless = false;        // --headless: yarpview-qt6 hands over to yarpview-qt6-headless
     bool freeze = false;
     bool compact = false;
     bool minimal = false;
     bool keepAbove = false;
+    std::string scaling = "nearest"; // display scaling kernel: nearest, bilinear, area
     bool saveOptions = false; // --saveoptions
     int refreshMs = 30; // polling/refresh period
+    // Depth / float visualization (--depth, --colormap, --near/--far, --autorange)
+    bool depth = false;
+    std::string colormap = "jet";
+    double depthNear = 0.0;
+    double depthFar = 0.0;
+    bool depthAutoRange = true;
+    // Image set recording (--rec-format, --rec-quality, --rec-threads, --rec-queue)
+    std::string recFormat = "png";
+    int recQuality = -1;
+    int recThreads = 2;
+    int recQueue = 16;
+    // Stream recording / playback (--record, --replay, --replay-speed, --replay-loop)
+    std::string recordFile;
+    std::string replayFile;
+    double replaySpeed = 1.0; // 0: as fast as possible
+    bool replayLoop = false;
+    // Flight recorder (--flight, --flight-mb, --flight-compress, --flight-dir)
+    double flightSeconds = 0.0; // pre-roll kept in memory, 0 = off
+    int flightMB = 256;
+    bool flightCompress = false;
+    std::string flightDir = ".";
+    std::string flightTriggerPortName; // <basename>/flight:i when --flight is given
+    // Re-publish output (--out, --out-scale, --out-rate, --out-jpeg)
+    std::string relayOutPortName; // <basename>/out:o when --out is given
+    bool relayEnabled = false;
+    double relayScale = 0.5;
+    double relayRate = 0.0;   // fps, 0 = every frame
+    int relayJpegQuality = -1; // -1 = raw pixels
+    std::string traceFile; // --trace: Chrome trace-event JSON written on exit
     int winW = 0;
     int winH = 0;
 
@@ -27,6 +73,7 @@ struct YarpViewOptions {
     bool hasW = false;
     bool hasH = false;
     bool helpRequested = false; // set when --help/-h specified
+    std::string error;          // invalid combination of options: reported and the program exits
 };
 
 class OptionsParser {
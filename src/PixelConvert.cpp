@@ -0,0 +1,213 @@
+#include "PixelConvert.h"
+#include "SimdSupport.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+inline std::uint8_t clampByte(float v) {
+    if (!(v > 0.0f)) return 0; // also maps NaN to 0
+    if (v >= 255.0f) return 255;
+    return std::uint8_t(v);
+}
+
+void monoFloatToGray8Scalar(const float *src, std::uint8_t *dst, int n) {
+    for (int i=0; i<n; ++i) dst[i] = clampByte(src[i]);
+}
+
+void rgbFloatToBgraScalar(const float *src, std::uint8_t *dst, int n) {
+    for (int i=0; i<n; ++i, src+=3, dst+=4) {
+        dst[0] = clampByte(src[2]);
+        dst[1] = clampByte(src[1]);
+        dst[2] = clampByte(src[0]);
+        dst[3] = 255;
+    }
+}
+
+// Column sums for boxDecimate: acc[i] += src[i] over n bytes
+void accumulateRowScalar(const std::uint8_t *src, std::uint16_t *acc, int n) {
+    for (int i=0; i<n; ++i) acc[i] = std::uint16_t(acc[i] + src[i]);
+}
+
+#ifdef YV_X86
+// Truncating float->int conversion followed by saturating packs gives the same
+// result as clampByte(): negatives and NaN (0x80000000) saturate to 0. Values
+// are first capped at 255, as +inf and anything from 2^31 would also convert to
+// 0x80000000; min(255, v) returns v for NaN, so NaN still ends up as 0.
+YV_TARGET("ssse3")
+void monoFloatToGray8Ssse3(const float *src, std::uint8_t *dst, int n) {
+    const __m128 top = _mm_set1_ps(255.0f);
+    int i = 0;
+    for (; i+16<=n; i+=16) {
+        __m128i a = _mm_cvttps_epi32(_mm_min_ps(top, _mm_loadu_ps(src+i)));
+        __m128i b = _mm_cvttps_epi32(_mm_min_ps(top, _mm_loadu_ps(src+i+4)));
+        __m128i c = _mm_cvttps_epi32(_mm_min_ps(top, _mm_loadu_ps(src+i+8)));
+        __m128i d = _mm_cvttps_epi32(_mm_min_ps(top, _mm_loadu_ps(src+i+12)));
+        __m128i ab = _mm_packs_epi32(a, b);
+        __m128i cd = _mm_packs_epi32(c, d);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i), _mm_packus_epi16(ab, cd));
+    }
+    monoFloatToGray8Scalar(src+i, dst+i, n-i);
+}
+
+YV_TARGET("ssse3")
+void rgbFloatToBgraSsse3(const float *src, std::uint8_t *dst, int n) {
+    // 4 pixels = 12 floats -> 12 packed RGB bytes -> shuffled to BGRA with alpha or-ed in
+    const __m128i shuffle = _mm_setr_epi8(2,1,0,-1, 5,4,3,-1, 8,7,6,-1, 11,10,9,-1);
+    const __m128i alpha = _mm_set1_epi32(int(0xFF000000u));
+    const __m128 top = _mm_set1_ps(255.0f);
+    int i = 0;
+    for (; i+4<=n; i+=4, src+=12, dst+=16) {
+        __m128i a = _mm_cvttps_epi32(_mm_min_ps(top, _mm_loadu_ps(src)));
+        __m128i b = _mm_cvttps_epi32(_mm_min_ps(top, _mm_loadu_ps(src+4)));
+        __m128i c = _mm_cvttps_epi32(_mm_min_ps(top, _mm_loadu_ps(src+8)));
+        __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, c));
+        __m128i bgra = _mm_or_si128(_mm_shuffle_epi8(bytes, shuffle), alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), bgra);
+    }
+    rgbFloatToBgraScalar(src, dst, n-i);
+}
+
+YV_TARGET("ssse3")
+void accumulateRowSsse3(const std::uint8_t *src, std::uint16_t *acc, int n) {
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i+16<=n; i+=16) {
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+        __m128i *lo = reinterpret_cast<__m128i*>(acc+i);
+        __m128i *hi = reinterpret_cast<__m128i*>(acc+i+8);
+        _mm_storeu_si128(lo, _mm_add_epi16(_mm_loadu_si128(lo), _mm_unpacklo_epi8(b, zero)));
+        _mm_storeu_si128(hi, _mm_add_epi16(_mm_loadu_si128(hi), _mm_unpackhi_epi8(b, zero)));
+    }
+    accumulateRowScalar(src+i, acc+i, n-i);
+}
+
+YV_TARGET("avx2")
+void monoFloatToGray8Avx2(const float *src, std::uint8_t *dst, int n) {
+    const __m256 top = _mm256_set1_ps(255.0f);
+    int i = 0;
+    for (; i+32<=n; i+=32) {
+        __m256i a = _mm256_cvttps_epi32(_mm256_min_ps(top, _mm256_loadu_ps(src+i)));
+        __m256i b = _mm256_cvttps_epi32(_mm256_min_ps(top, _mm256_loadu_ps(src+i+8)));
+        __m256i c = _mm256_cvttps_epi32(_mm256_min_ps(top, _mm256_loadu_ps(src+i+16)));
+        __m256i d = _mm256_cvttps_epi32(_mm256_min_ps(top, _mm256_loadu_ps(src+i+24)));
+        // AVX2 packs work per 128-bit lane; the final permute restores element order
+        __m256i ab = _mm256_packs_epi32(a, b);
+        __m256i cd = _mm256_packs_epi32(c, d);
+        __m256i bytes = _mm256_packus_epi16(ab, cd);
+        bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0,4,1,5,2,6,3,7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i), bytes);
+    }
+    monoFloatToGray8Ssse3(src+i, dst+i, n-i);
+}
+
+YV_TARGET("avx2")
+void rgbFloatToBgraAvx2(const float *src, std::uint8_t *dst, int n) {
+    // 8 pixels = 24 floats per iteration; each 128-bit lane handles 4 pixels
+    const __m256i shuffle = _mm256_setr_epi8(2,1,0,-1, 5,4,3,-1, 8,7,6,-1, 11,10,9,-1,
+                                             2,1,0,-1, 5,4,3,-1, 8,7,6,-1, 11,10,9,-1);
+    const __m256i alpha = _mm256_set1_epi32(int(0xFF000000u));
+    const __m256 top = _mm256_set1_ps(255.0f);
+    int i = 0;
+    for (; i+8<=n; i+=8, src+=24, dst+=32) {
+        // lane 0: pixels 0..3 (floats 0..11), lane 1: pixels 4..7 (floats 12..23)
+        __m256i a = _mm256_cvttps_epi32(_mm256_min_ps(top, _mm256_setr_m128(_mm_loadu_ps(src), _mm_loadu_ps(src+12))));
+        __m256i b = _mm256_cvttps_epi32(_mm256_min_ps(top, _mm256_setr_m128(_mm_loadu_ps(src+4), _mm_loadu_ps(src+16))));
+        __m256i c = _mm256_cvttps_epi32(_mm256_min_ps(top, _mm256_setr_m128(_mm_loadu_ps(src+8), _mm_loadu_ps(src+20))));
+        __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, c));
+        __m256i bgra = _mm256_or_si256(_mm256_shuffle_epi8(bytes, shuffle), alpha);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), bgra);
+    }
+    rgbFloatToBgraSsse3(src, dst, n-i);
+}
+
+YV_TARGET("avx2")
+void accumulateRowAvx2(const std::uint8_t *src, std::uint16_t *acc, int n) {
+    int i = 0;
+    for (; i+16<=n; i+=16) {
+        __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i)));
+        __m256i *a = reinterpret_cast<__m256i*>(acc+i);
+        _mm256_storeu_si256(a, _mm256_add_epi16(_mm256_loadu_si256(a), b));
+    }
+    accumulateRowScalar(src+i, acc+i, n-i);
+}
+
+#endif
+
+struct Dispatch {
+    void (*monoFloatToGray8)(const float*, std::uint8_t*, int) = monoFloatToGray8Scalar;
+    void (*rgbFloatToBgra)(const float*, std::uint8_t*, int) = rgbFloatToBgraScalar;
+    void (*accumulateRow)(const std::uint8_t*, std::uint16_t*, int) = accumulateRowScalar;
+    const char *name = "scalar";
+
+    Dispatch() {
+#ifdef YV_X86
+        if (SimdSupport::hasAvx2()) {
+            monoFloatToGray8 = monoFloatToGray8Avx2;
+            rgbFloatToBgra = rgbFloatToBgraAvx2;
+            accumulateRow = accumulateRowAvx2;
+            name = "avx2";
+        } else if (SimdSupport::hasSsse3()) {
+            monoFloatToGray8 = monoFloatToGray8Ssse3;
+            rgbFloatToBgra = rgbFloatToBgraSsse3;
+            accumulateRow = accumulateRowSsse3;
+            name = "ssse3";
+        }
+#endif
+    }
+};
+
+const Dispatch &dispatch() {
+    static const Dispatch d;
+    return d;
+}
+
+}
+
+namespace PixelConvert {
+
+void monoFloatToGray8(const float *src, std::uint8_t *dst, int n) { dispatch().monoFloatToGray8(src, dst, n); }
+void rgbFloatToBgra(const float *src, std::uint8_t *dst, int n) { dispatch().rgbFloatToBgra(src, dst, n); }
+const char *isaName() { return dispatch().name; }
+
+bool boxDecimate(const std::uint8_t *src, std::size_t srcStride, int sw, int sh, int bpp, int factor,
+                 std::uint8_t *dst, std::size_t dstStride) {
+    if (factor < 1 || factor > MAX_DECIMATE) return false;
+    const int f = factor;
+    const int dw = sw / f, dh = sh / f;
+    if (dw <= 0 || dh <= 0) return false;
+    const int rowBytes = dw * f * bpp;
+    // Vertical pass (SIMD) sums f source rows into 16-bit columns, the
+    // horizontal pass then sums f columns per channel and divides
+    thread_local std::vector<std::uint16_t> cols;
+    cols.resize(size_t(rowBytes));
+    const std::uint32_t area = std::uint32_t(f * f);
+    const std::uint64_t recip = ((std::uint64_t(1) << 32) + area - 1) / area;
+    const auto accumulate = dispatch().accumulateRow;
+    for (int y=0; y<dh; ++y) {
+        std::fill(cols.begin(), cols.end(), std::uint16_t(0));
+        for (int k=0; k<f; ++k) accumulate(src + size_t(y*f + k)*srcStride, cols.data(), rowBytes);
+        std::uint8_t *out = dst + size_t(y)*dstStride;
+        const std::uint16_t *c = cols.data();
+        for (int x=0; x<dw; ++x, c += f*bpp) {
+            for (int ch=0; ch<bpp; ++ch) {
+                std::uint32_t sum = 0;
+                for (int k=0; k<f; ++k) sum += c[k*bpp + ch];
+                *out++ = std::uint8_t(((sum + area/2) * recip) >> 32);
+            }
+        }
+    }
+    return true;
+}
+
+bool alphaUnused(const std::uint8_t *src, std::size_t stride, int w, int h, int alphaOffset) {
+    const int rows[3] = {0, h/2, h-1};
+    for (int r : rows) {
+        const std::uint8_t *p = src + size_t(r)*stride + alphaOffset;
+        for (int x=0; x<w; ++x, p+=4) if (*p != 0xFF) return false;
+    }
+    return true;
+}
+
+}
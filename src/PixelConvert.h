@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Row conversion kernels for pixel codes that QImage cannot display directly.
+// Each function converts n pixels of one row. The best implementation for the
+// running CPU (AVX2, SSSE3/SSE2 or scalar) is selected once at startup.
+namespace PixelConvert {
+
+// PixelFloat (0..255 range, as YARP's own conversions assume) -> 8 bit gray.
+void monoFloatToGray8(const float *src, std::uint8_t *dst, int n);
+// PixelRgbFloat (0..255) -> BGRA bytes with opaque alpha (QImage::Format_RGB32).
+void rgbFloatToBgra(const float *src, std::uint8_t *dst, int n);
+
+// Area-average reduction by an integer factor (1..MAX_DECIMATE) of 1, 3 or 4
+// byte pixels; channels are averaged independently, so any byte order works.
+// Output is (sw/factor) x (sh/factor); source columns and rows that do not
+// fill a whole block are left out. Returns false, writing nothing, for a
+// factor out of range: dst is sized by the caller from the same factor.
+constexpr int MAX_DECIMATE = 64; // 64*64*255 still fits the 32-bit block sums
+bool boxDecimate(const std::uint8_t *src, std::size_t srcStride, int sw, int sh, int bpp, int factor,
+                 std::uint8_t *dst, std::size_t dstStride);
+
+// True if the alpha byte (at alphaOffset in 4 byte pixels) is 0xFF on the
+// first, middle and last rows. Sampling three rows keeps the check negligible
+// next to a copy of the frame.
+bool alphaUnused(const std::uint8_t *src, std::size_t stride, int w, int h, int alphaOffset);
+
+// Name of the instruction set picked by the dispatcher ("avx2", "ssse3", "scalar").
+const char *isaName();
+
+}
@@ -0,0 +1,73 @@
+#include "RateStats.h"
+#include <algorithm>
+#include <cmath>
+
+RateStats::MonotonicQueue::MonotonicQueue(size_t capacity, bool keepMax)
+    : items(capacity), keepMax(keepMax) {}
+
+void RateStats::MonotonicQueue::push(quint64 seq, double v) {
+    // Drop from the back everything the new value dominates
+    while (size > 0) {
+        const Item &back = items[(head + size - 1) % items.size()];
+        if (keepMax ? back.value > v : back.value < v) break;
+        size--;
+    }
+    items[(head + size) % items.size()] = Item{seq, v};
+    size++;
+}
+
+void RateStats::MonotonicQueue::expire(quint64 oldestSeq) {
+    while (size > 0 && items[head].seq < oldestSeq) {
+        head = (head + 1) % items.size();
+        size--;
+    }
+}
+
+RateStats::RateStats(int window)
+    : ring(size_t(std::max(window, 1))), minQueue(ring.size(), false), maxQueue(ring.size(), true) {}
+
+void RateStats::tick() {
+    if (!timer.isValid()) {
+        timer.start();
+        return;
+    }
+    addInterval(timer.nsecsElapsed() / 1e6);
+    timer.restart();
+}
+
+void RateStats::addInterval(double ms) {
+    if (!(ms > 0.0)) return;
+    if (n == ring.size()) {
+        sum -= ring[next];
+    } else {
+        n++;
+    }
+    ring[next] = ms;
+    sum += ms;
+    next = (next + 1) % ring.size();
+    // The running sum picks up rounding error: recompute it once per lap
+    if (next == 0) {
+        sum = 0.0;
+        for (size_t i=0; i<n; ++i) sum += ring[i];
+    }
+    seq++;
+    const quint64 oldest = seq > ring.size() ? seq - ring.size() + 1 : 0;
+    minQueue.expire(oldest);
+    maxQueue.expire(oldest);
+    minQueue.push(seq, ms);
+    maxQueue.push(seq, ms);
+    jitter.add(std::abs(ms - meanMs()));
+}
+
+double RateStats::minMs() const { return minQueue.empty() ? 0.0 : minQueue.front(); }
+double RateStats::maxMs() const { return maxQueue.empty() ? 0.0 : maxQueue.front(); }
+
+void RateStats::reset() {
+    timer.invalidate();
+    next = n = 0;
+    seq = 0;
+    sum = 0.0;
+    minQueue.clear();
+    maxQueue.clear();
+    jitter.reset();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <QElapsedTimer>
+#include <vector>
+#include "LatencyStats.h"
+
+// Event-rate statistics over a sliding window of intervals, O(1) per event:
+// a ring buffer with a running sum for the mean, monotonic queues for the
+// window min/max and a histogram sketch of the jitter (|interval - mean|).
+class RateStats {
+public:
+    explicit RateStats(int window=120);
+
+    // Record an event now; the first call only starts the clock.
+    void tick();
+    void addInterval(double ms);
+    void reset();
+
+    int count() const { return int(n); }
+    double meanMs() const { return n ? sum / double(n) : 0.0; }
+    double minMs() const;
+    double maxMs() const;
+    double hz() const { const double m = meanMs(); return m > 0.0 ? 1000.0/m : 0.0; }
+    double minHz() const { const double m = maxMs(); return m > 0.0 ? 1000.0/m : 0.0; }
+    double maxHz() const { const double m = minMs(); return m > 0.0 ? 1000.0/m : 0.0; }
+    // Jitter percentile (p in [0,1]) since the last reset, ms
+    double jitterMs(double p=0.95) const { return jitter.percentile(p); }
+
+private:
+    // Sliding-window extreme: values that can never become the extreme are
+    // discarded on push, so the front always holds it.
+    class MonotonicQueue {
+    public:
+        explicit MonotonicQueue(size_t capacity, bool keepMax);
+        void push(quint64 seq, double v);
+        void expire(quint64 oldestSeq);
+        bool empty() const { return size == 0; }
+        double front() const { return items[head].value; }
+        void clear() { head = size = 0; }
+    private:
+        struct Item { quint64 seq; double value; };
+        std::vector<Item> items;
+        size_t head{0};
+        size_t size{0};
+        bool keepMax;
+    };
+
+    QElapsedTimer timer;
+    std::vector<double> ring;
+    size_t next{0};
+    size_t n{0};
+    quint64 seq{0};
+    double sum{0.0};
+    MonotonicQueue minQueue;
+    MonotonicQueue maxQueue;
+    LatencyHistogram jitter;
+};
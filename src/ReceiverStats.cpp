@@ -0,0 +1,90 @@
+#include "ReceiverStats.h"
+#include <algorithm>
+#include <string>
+
+namespace ReceiverStats {
+
+void addValues(yarp::os::Bottle &b, const char *key, std::initializer_list<double> values) {
+    yarp::os::Bottle &l = b.addList();
+    l.addString(key);
+    for (double v : values) l.addFloat64(v);
+}
+
+void addCount(yarp::os::Bottle &b, const char *key, quint64 value) {
+    yarp::os::Bottle &l = b.addList();
+    l.addString(key);
+    l.addInt64(qint64(value));
+}
+
+void addPortRate(yarp::os::Bottle &b, const RateStats &rate) {
+    addValues(b, "port_hz", {rate.hz(), rate.minHz(), rate.maxHz()});
+    addValues(b, "port_jitter_ms", {rate.jitterMs(0.5), rate.jitterMs(0.95)});
+}
+
+void addLatency(yarp::os::Bottle &b, const LatencyStats &latency, std::initializer_list<LatencyStats::Stage> stages) {
+    for (LatencyStats::Stage s : stages) {
+        const LatencyHistogram &h = latency.stage(s);
+        const std::string key = std::string("latency_") + LatencyStats::stageName(s) + "_ms";
+        addValues(b, key.c_str(), {h.percentile(0.50), h.percentile(0.95), h.percentile(0.99), h.max()});
+    }
+}
+
+void addReceiver(yarp::os::Bottle &b, const ImageReceiver &receiver, int width, int height, quint64 displayDropped) {
+    addCount(b, "received", receiver.framesReceived());
+    addCount(b, "dropped", receiver.framesDropped() + displayDropped);
+    addCount(b, "transport_dropped", receiver.transportDropped());
+    yarp::os::Bottle &l = b.addList();
+    l.addString("image");
+    l.addInt32(std::max(width, 0));
+    l.addInt32(std::max(height, 0));
+    l.addString(ImageReceiver::pixelCodeName(receiver.pixelCode()).toStdString());
+}
+
+void addQueue(yarp::os::Bottle &b, const ImageReceiver::QueueStats &qs) {
+    yarp::os::Bottle &l = b.addList();
+    l.addString("queue");
+    l.addString(ImageReceiver::readPolicyName(qs.policy));
+    l.addInt32(qs.depth);
+    l.addInt32(qs.pending);
+    l.addInt32(qs.maxPending);
+    l.addInt64(qint64(qs.skipped));
+    l.addInt64(qint64(qs.flushes));
+    l.addInt64(qint64(qs.portDropped));
+}
+
+void addFlight(yarp::os::Bottle &b, const FlightRecorder::Stats &fs) {
+    yarp::os::Bottle &l = b.addList();
+    l.addString("flight");
+    l.addInt32(fs.frames);
+    l.addFloat64(fs.seconds);
+    l.addInt64(fs.bytes);
+    l.addInt64(qint64(fs.dumps));
+    l.addInt64(qint64(fs.dumpFailed));
+}
+
+void addRelay(yarp::os::Bottle &b, const StreamRelay::Stats &os) {
+    yarp::os::Bottle &l = b.addList();
+    l.addString("relay");
+    l.addInt32(os.size.width());
+    l.addInt32(os.size.height());
+    l.addInt64(qint64(os.published));
+    l.addInt64(qint64(os.bytes));
+    l.addInt64(qint64(os.decimated));
+    l.addInt64(qint64(os.superseded));
+    l.addFloat64(os.workMs);
+}
+
+int pollFlightTrigger(yarp::os::BufferedPort<yarp::os::Bottle> &port, FlightRecorder &flight, const QString &dir) {
+    int dumps = 0;
+    while (yarp::os::Bottle *b = port.read(false)) {
+        QString name;
+        if (b->size() > 0 && b->get(0).isString()) name = QString::fromStdString(b->get(0).asString());
+        const QString path = FlightRecorder::dumpPath(dir, name);
+        if (path.isEmpty()) continue;
+        flight.dump(path);
+        ++dumps;
+    }
+    return dumps;
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <QString>
+#include <initializer_list>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include "FlightRecorder.h"
+#include "ImageReceiver.h"
+#include "LatencyStats.h"
+#include "RateStats.h"
+#include "StreamRelay.h"
+
+// The stats:o entries and the flight recorder trigger shared by the window
+// and the headless viewer, so both publish the same layout. Each entry is a
+// list headed by its key; display-only entries stay with MainWindow.
+namespace ReceiverStats {
+
+void addValues(yarp::os::Bottle &b, const char *key, std::initializer_list<double> values);
+void addCount(yarp::os::Bottle &b, const char *key, quint64 value);
+
+// port_hz (mean, min, max) and port_jitter_ms (p50, p95)
+void addPortRate(yarp::os::Bottle &b, const RateStats &rate);
+// latency_<stage>_ms (p50, p95, p99, max) for each stage
+void addLatency(yarp::os::Bottle &b, const LatencyStats &latency, std::initializer_list<LatencyStats::Stage> stages);
+// received, dropped, transport_dropped and image (width, height, pixel code);
+// displayDropped: frames the caller took but never showed, added to dropped
+void addReceiver(yarp::os::Bottle &b, const ImageReceiver &receiver, int width, int height, quint64 displayDropped=0);
+void addQueue(yarp::os::Bottle &b, const ImageReceiver::QueueStats &qs);
+void addFlight(yarp::os::Bottle &b, const FlightRecorder::Stats &fs);
+void addRelay(yarp::os::Bottle &b, const StreamRelay::Stats &os);
+
+// Dumps once per message waiting on the trigger port; a string in the
+// message names the file. Returns the number of dumps started.
+int pollFlightTrigger(yarp::os::BufferedPort<yarp::os::Bottle> &port, FlightRecorder &flight, const QString &dir);
+
+}
@@ -0,0 +1,293 @@
+#include "ScaleKernels.h"
+#include "SimdSupport.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+using ScaleKernels::Kernel;
+
+void nearestRowScalar(const std::uint32_t *src, std::uint32_t *dst, const int *xmap, int n) {
+    for (int i=0; i<n; ++i) dst[i] = src[xmap[i]];
+}
+
+#ifdef YV_X86
+YV_TARGET("avx2")
+void nearestRowAvx2(const std::uint32_t *src, std::uint32_t *dst, const int *xmap, int n) {
+    int i = 0;
+    for (; i+8<=n; i+=8) {
+        __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xmap+i));
+        __m256i px = _mm256_i32gather_epi32(reinterpret_cast<const int*>(src), idx, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i), px);
+    }
+    nearestRowScalar(src, dst+i, xmap+i, n-i);
+}
+#endif
+
+using NearestRowFn = void (*)(const std::uint32_t*, std::uint32_t*, const int*, int);
+
+NearestRowFn nearestRow() {
+    static const NearestRowFn fn = [] {
+#ifdef YV_X86
+        if (SimdSupport::hasAvx2()) return NearestRowFn(nearestRowAvx2);
+#endif
+        return NearestRowFn(nearestRowScalar);
+    }();
+    return fn;
+}
+
+inline std::uint32_t lerpPixelScalar(std::uint32_t a, std::uint32_t b, int f) {
+    std::uint32_t out = 0;
+    for (int c=0; c<32; c+=8) {
+        int va = (a >> c) & 0xFF, vb = (b >> c) & 0xFF;
+        out |= std::uint32_t((va*(256-f) + vb*f + 128) >> 8) << c;
+    }
+    return out;
+}
+
+}
+
+namespace ScaleKernels {
+
+const char *kernelName(Kernel k) {
+    switch (k) {
+    case Kernel::Nearest: return "nearest";
+    case Kernel::Bilinear: return "bilinear";
+    case Kernel::Area: return "area";
+    }
+    return "nearest";
+}
+
+bool kernelFromName(const char *name, Kernel &k) {
+    for (Kernel c : {Kernel::Nearest, Kernel::Bilinear, Kernel::Area}) {
+        if (std::strcmp(name, kernelName(c)) == 0) { k = c; return true; }
+    }
+    return false;
+}
+
+void halve(const std::uint8_t *src, std::size_t srcStride, int sw, int sh,
+           std::uint8_t *dst, std::size_t dstStride) {
+    const int dw = std::max(sw/2, 1), dh = std::max(sh/2, 1);
+    for (int y=0; y<dh; ++y) {
+        const std::uint32_t *a = reinterpret_cast<const std::uint32_t*>(src + std::min(2*y, sh-1)*srcStride);
+        const std::uint32_t *b = reinterpret_cast<const std::uint32_t*>(src + std::min(2*y+1, sh-1)*srcStride);
+        std::uint32_t *out = reinterpret_cast<std::uint32_t*>(dst + y*dstStride);
+        int x = 0;
+#ifdef YV_X86
+        if (sw >= 2) {
+            // 4 output pixels per step: even/odd pixel pairs of both rows summed
+            // in 16 bits and rounded once, exactly as the scalar tail does
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i two = _mm_set1_epi16(2);
+            for (; x+4<=dw && 2*x+8<=sw; x+=4) {
+                __m128 a0 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a+2*x)));
+                __m128 a1 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a+2*x+4)));
+                __m128 b0 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b+2*x)));
+                __m128 b1 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b+2*x+4)));
+                __m128i ae = _mm_castps_si128(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2,0,2,0)));
+                __m128i ao = _mm_castps_si128(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3,1,3,1)));
+                __m128i be = _mm_castps_si128(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2,0,2,0)));
+                __m128i bo = _mm_castps_si128(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3,1,3,1)));
+                __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(ae, zero), _mm_unpacklo_epi8(ao, zero)),
+                                           _mm_add_epi16(_mm_unpacklo_epi8(be, zero), _mm_unpacklo_epi8(bo, zero)));
+                __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(ae, zero), _mm_unpackhi_epi8(ao, zero)),
+                                           _mm_add_epi16(_mm_unpackhi_epi8(be, zero), _mm_unpackhi_epi8(bo, zero)));
+                lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+                hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out+x), _mm_packus_epi16(lo, hi));
+            }
+        }
+#endif
+        for (; x<dw; ++x) {
+            const int x0 = std::min(2*x, sw-1), x1 = std::min(2*x+1, sw-1);
+            std::uint32_t v = 0;
+            for (int c=0; c<32; c+=8) {
+                int sum = ((a[x0]>>c)&0xFF) + ((a[x1]>>c)&0xFF) + ((b[x0]>>c)&0xFF) + ((b[x1]>>c)&0xFF);
+                v |= std::uint32_t((sum + 2) >> 2) << c;
+            }
+            out[x] = v;
+        }
+    }
+}
+
+Plan::Plan(int sw, int sh, int dw, int dh, Kernel k)
+    : srcW(sw), srcH(sh), dstW(dw), dstH(dh), kernel(k) {
+    switch (k) {
+    case Kernel::Nearest: xt = nearestTaps(sw, dw); yt = nearestTaps(sh, dh); break;
+    case Kernel::Bilinear: xt = bilinearTaps(sw, dw); yt = bilinearTaps(sh, dh); break;
+    case Kernel::Area: xt = areaTaps(sw, dw); yt = areaTaps(sh, dh); break;
+    }
+}
+
+Plan::Taps Plan::nearestTaps(int s, int d) {
+    Taps t;
+    t.first.resize(d);
+    for (int i=0; i<d; ++i) t.first[i] = std::min(int((i + 0.5) * s / d), s-1);
+    return t;
+}
+
+Plan::Taps Plan::bilinearTaps(int s, int d) {
+    // Pixel-centre aligned. Taps are first[i] and first[i]+1, so first[i] is
+    // kept <= s-2 (with frac 256 at the right edge) to stay inside the row.
+    Taps t;
+    t.first.resize(d);
+    t.frac.resize(d);
+    for (int i=0; i<d; ++i) {
+        double pos = std::clamp((i + 0.5) * s / d - 0.5, 0.0, double(s-1));
+        int x0 = int(pos);
+        int f = int(std::lround((pos - x0) * 256.0));
+        if (s < 2) { x0 = 0; f = 0; }
+        else if (x0 >= s-1) { x0 = s-2; f = 256; }
+        t.first[i] = x0;
+        t.frac[i] = f;
+    }
+    return t;
+}
+
+Plan::Taps Plan::areaTaps(int s, int d) {
+    // Output pixel i covers source interval [i*r, (i+1)*r); each source pixel
+    // is weighted by its overlap. Also well defined when upscaling (r < 1).
+    Taps t;
+    t.first.resize(d);
+    t.count.resize(d);
+    t.offset.resize(d);
+    const double r = double(s) / d;
+    for (int i=0; i<d; ++i) {
+        double a = i * r, b = std::min((i + 1) * r, double(s));
+        int first = std::min(int(a), s-1);
+        int last = std::min(int(std::ceil(b)) - 1, s-1);
+        last = std::max(last, first);
+        t.first[i] = first;
+        t.count[i] = last - first + 1;
+        t.offset[i] = int(t.weights.size());
+        for (int j=first; j<=last; ++j) {
+            double ov = std::min(b, j + 1.0) - std::max(a, double(j));
+            t.weights.push_back(float(std::max(ov, 0.0) / (b - a)));
+        }
+    }
+    return t;
+}
+
+void Plan::run(const std::uint8_t *src, std::size_t srcStride,
+               std::uint8_t *dst, std::size_t dstStride, int y0, int y1) const {
+    switch (kernel) {
+    case Kernel::Nearest: runNearest(src, srcStride, dst, dstStride, y0, y1); break;
+    case Kernel::Bilinear: runBilinear(src, srcStride, dst, dstStride, y0, y1); break;
+    case Kernel::Area: runArea(src, srcStride, dst, dstStride, y0, y1); break;
+    }
+}
+
+void Plan::runNearest(const std::uint8_t *src, std::size_t srcStride, std::uint8_t *dst, std::size_t dstStride, int y0, int y1) const {
+    const NearestRowFn row = nearestRow();
+    for (int y=y0; y<y1; ++y) {
+        row(reinterpret_cast<const std::uint32_t*>(src + yt.first[y]*srcStride),
+            reinterpret_cast<std::uint32_t*>(dst + y*dstStride), xt.first.data(), dstW);
+    }
+}
+
+void Plan::runBilinear(const std::uint8_t *src, std::size_t srcStride, std::uint8_t *dst, std::size_t dstStride, int y0, int y1) const {
+    for (int y=y0; y<y1; ++y) {
+        const int sy = yt.first[y];
+        const int fy = yt.frac[y];
+        const std::uint8_t *rowA = src + sy*srcStride;
+        const std::uint8_t *rowB = srcH > 1 ? rowA + srcStride : rowA;
+        std::uint32_t *out = reinterpret_cast<std::uint32_t*>(dst + y*dstStride);
+        if (srcW < 2) {
+            const std::uint32_t a = *reinterpret_cast<const std::uint32_t*>(rowA);
+            const std::uint32_t b = *reinterpret_cast<const std::uint32_t*>(rowB);
+            std::fill(out, out+dstW, lerpPixelScalar(a, b, fy));
+            continue;
+        }
+#ifdef YV_X86
+        // SSE2 (x86-64 baseline): both horizontal taps of a row are loaded as one
+        // 64-bit chunk and blended as 16-bit lanes; products stay below 2^16.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16(128);
+        const __m128i wy = _mm_unpacklo_epi64(_mm_set1_epi16(short(256-fy)), _mm_set1_epi16(short(fy)));
+        for (int x=0; x<dstW; ++x) {
+            const int sx = xt.first[x];
+            const int fx = xt.frac[x];
+            const __m128i wx = _mm_unpacklo_epi64(_mm_set1_epi16(short(256-fx)), _mm_set1_epi16(short(fx)));
+            __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rowA + sx*4)), zero);
+            __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rowB + sx*4)), zero);
+            a = _mm_mullo_epi16(a, wx);
+            b = _mm_mullo_epi16(b, wx);
+            a = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(a, _mm_srli_si128(a, 8)), round), 8);
+            b = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(b, _mm_srli_si128(b, 8)), round), 8);
+            __m128i v = _mm_mullo_epi16(_mm_unpacklo_epi64(a, b), wy);
+            v = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(v, _mm_srli_si128(v, 8)), round), 8);
+            out[x] = std::uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(v, zero)));
+        }
+#else
+        for (int x=0; x<dstW; ++x) {
+            const int sx = xt.first[x];
+            const int fx = xt.frac[x];
+            const std::uint32_t *pa = reinterpret_cast<const std::uint32_t*>(rowA) + sx;
+            const std::uint32_t *pb = reinterpret_cast<const std::uint32_t*>(rowB) + sx;
+            out[x] = lerpPixelScalar(lerpPixelScalar(pa[0], pa[1], fx), lerpPixelScalar(pb[0], pb[1], fx), fy);
+        }
+#endif
+    }
+}
+
+void Plan::runArea(const std::uint8_t *src, std::size_t srcStride, std::uint8_t *dst, std::size_t dstStride, int y0, int y1) const {
+    // Separable box filter in float, 4 channels per vector: contributing source
+    // rows are first summed with their vertical weights into one float row, which
+    // is then resampled horizontally. Each source row is touched about once.
+    std::vector<float> rowAcc(std::size_t(srcW) * 4);
+    for (int y=y0; y<y1; ++y) {
+        std::fill(rowAcc.begin(), rowAcc.end(), 0.0f);
+        const float *wys = yt.weights.data() + yt.offset[y];
+        for (int k=0; k<yt.count[y]; ++k) {
+            const std::uint32_t *row = reinterpret_cast<const std::uint32_t*>(src + (yt.first[y]+k)*srcStride);
+            const float wy = wys[k];
+#ifdef YV_X86
+            const __m128i zero = _mm_setzero_si128();
+            const __m128 vwy = _mm_set1_ps(wy);
+            int x = 0;
+            for (; x+4<=srcW; x+=4) {
+                // 4 pixels -> 16 bytes -> 4 vectors of 4 channels
+                __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                __m128i lo = _mm_unpacklo_epi8(px, zero), hi = _mm_unpackhi_epi8(px, zero);
+                __m128i c[4] = { _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+                                 _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero) };
+                float *a = rowAcc.data() + 4*x;
+                for (int j=0; j<4; ++j) {
+                    _mm_storeu_ps(a + 4*j, _mm_add_ps(_mm_loadu_ps(a + 4*j), _mm_mul_ps(_mm_cvtepi32_ps(c[j]), vwy)));
+                }
+            }
+            for (; x<srcW; ++x) {
+                for (int ch=0; ch<4; ++ch) rowAcc[4*x+ch] += float((row[x] >> (8*ch)) & 0xFF) * wy;
+            }
+#else
+            for (int x=0; x<srcW; ++x) {
+                for (int ch=0; ch<4; ++ch) rowAcc[4*x+ch] += float((row[x] >> (8*ch)) & 0xFF) * wy;
+            }
+#endif
+        }
+        std::uint32_t *out = reinterpret_cast<std::uint32_t*>(dst + y*dstStride);
+        for (int x=0; x<dstW; ++x) {
+            const float *a = rowAcc.data() + 4*xt.first[x];
+            const float *wxs = xt.weights.data() + xt.offset[x];
+            const int n = xt.count[x];
+#ifdef YV_X86
+            __m128 sum = _mm_set1_ps(0.5f); // rounding
+            for (int j=0; j<n; ++j) sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + 4*j), _mm_set1_ps(wxs[j])));
+            __m128i v = _mm_cvttps_epi32(sum);
+            v = _mm_packs_epi32(v, v);
+            out[x] = std::uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(v, v)));
+#else
+            std::uint32_t v = 0;
+            for (int ch=0; ch<4; ++ch) {
+                float s = 0.5f;
+                for (int j=0; j<n; ++j) s += a[4*j+ch] * wxs[j];
+                v |= std::uint32_t(std::clamp(int(s), 0, 255)) << (8*ch);
+            }
+            out[x] = v;
+#endif
+        }
+    }
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Resampling kernels for 32-bit pixels (QImage RGB32 / ARGB32_Premultiplied).
+// A Plan holds the per-axis tables for one (source size, target size, kernel)
+// and can fill any band of output rows, so callers may split rows across threads.
+namespace ScaleKernels {
+
+enum class Kernel { Nearest, Bilinear, Area };
+
+const char *kernelName(Kernel k);
+bool kernelFromName(const char *name, Kernel &k);
+
+// 2x2 box downsample (one mip level); output is max(sw/2,1) x max(sh/2,1).
+void halve(const std::uint8_t *src, std::size_t srcStride, int sw, int sh,
+           std::uint8_t *dst, std::size_t dstStride);
+
+class Plan {
+public:
+    Plan() = default;
+    Plan(int sw, int sh, int dw, int dh, Kernel k);
+
+    bool matches(int sw, int sh, int dw, int dh, Kernel k) const {
+        return sw==srcW && sh==srcH && dw==dstW && dh==dstH && k==kernel;
+    }
+    // Fill output rows [y0, y1) from the whole source image.
+    void run(const std::uint8_t *src, std::size_t srcStride,
+             std::uint8_t *dst, std::size_t dstStride, int y0, int y1) const;
+
+private:
+    struct Taps {
+        std::vector<int> first;    // first source index per output index
+        std::vector<int> count;    // number of taps per output index (area)
+        std::vector<int> offset;   // start into weights (area)
+        std::vector<float> weights;
+        std::vector<int> frac;     // 0..256 fraction of the second tap (bilinear)
+    };
+    static Taps nearestTaps(int s, int d);
+    static Taps bilinearTaps(int s, int d);
+    static Taps areaTaps(int s, int d);
+
+    void runNearest(const std::uint8_t *src, std::size_t srcStride, std::uint8_t *dst, std::size_t dstStride, int y0, int y1) const;
+    void runBilinear(const std::uint8_t *src, std::size_t srcStride, std::uint8_t *dst, std::size_t dstStride, int y0, int y1) const;
+    void runArea(const std::uint8_t *src, std::size_t srcStride, std::uint8_t *dst, std::size_t dstStride, int y0, int y1) const;
+
+    int srcW{0}, srcH{0}, dstW{0}, dstH{0};
+    Kernel kernel{Kernel::Nearest};
+    Taps xt, yt;
+};
+
+}
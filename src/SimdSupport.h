@@ -0,0 +1,42 @@
+#pragma once
+// Shared helpers for the runtime-dispatched SIMD kernels. Kernels are compiled
+// per function with YV_TARGET(...) so the binary still runs on any x86-64 CPU.
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define YV_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define YV_TARGET(isa)
+#else
+#define YV_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace SimdSupport {
+
+inline bool hasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 1);
+    bool osxsave = (r[2] & (1<<27)) != 0;
+    __cpuidex(r, 7, 0);
+    return osxsave && (r[1] & (1<<5)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+inline bool hasSsse3() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 1);
+    return (r[2] & (1<<9)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+}
+#endif
@@ -0,0 +1,81 @@
+#include "StampMatcher.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+StampMatcher::StampMatcher(int ports, double toleranceMs, int capacity)
+    : rings(size_t(std::max(ports, 1))), capacity(size_t(std::max(capacity, 1))),
+      tolerance(std::max(toleranceMs, 0.0) / 1000.0) {}
+
+void StampMatcher::push(int port, FrameMailbox::Frame &&frame, double now) {
+    if (port < 0 || port >= ports()) return;
+    const double stamp = frame.stamp.isValid() ? frame.stamp.getTime() : now;
+    QMutexLocker lock(&mutex);
+    counters.pushed++;
+    std::deque<Entry> &ring = rings[size_t(port)];
+    if (!ring.empty() && stamp < ring.back().stamp - 1.0) {
+        // Stamps went back in time on this port: publisher restart
+        counters.unmatched += ring.size();
+        ring.clear();
+    }
+    auto pos = std::upper_bound(ring.begin(), ring.end(), stamp,
+        [](double s, const Entry &e) { return s < e.stamp; });
+    ring.insert(pos, Entry{std::move(frame), stamp});
+    while (ring.size() > capacity) {
+        ring.pop_front();
+        counters.unmatched++;
+    }
+
+    // The new frame can only complete a set it belongs to: look for the
+    // closest partner on every other port
+    std::vector<size_t> pick(rings.size());
+    for (size_t p=0; p<rings.size(); ++p) {
+        const std::deque<Entry> &r = rings[p];
+        if (r.empty()) return;
+        size_t best = 0;
+        for (size_t i=1; i<r.size(); ++i) {
+            if (std::abs(r[i].stamp - stamp) < std::abs(r[best].stamp - stamp)) best = i;
+        }
+        if (std::abs(r[best].stamp - stamp) > tolerance) return;
+        pick[p] = best;
+    }
+
+    if (hasReady) counters.superseded++;
+    ready.frames.resize(rings.size());
+    double lo = stamp, hi = stamp;
+    for (size_t p=0; p<rings.size(); ++p) {
+        std::deque<Entry> &r = rings[p];
+        lo = std::min(lo, r[pick[p]].stamp);
+        hi = std::max(hi, r[pick[p]].stamp);
+        ready.frames[p] = std::move(r[pick[p]].frame);
+        // Anything older can no longer be shown in order
+        counters.unmatched += pick[p];
+        r.erase(r.begin(), r.begin() + std::ptrdiff_t(pick[p]) + 1);
+    }
+    ready.skewMs = (hi - lo) * 1000.0;
+    hasReady = true;
+    counters.matched++;
+    counters.skew.add(ready.skewMs);
+}
+
+bool StampMatcher::take(Set &out) {
+    QMutexLocker lock(&mutex);
+    if (!hasReady) return false;
+    out = std::move(ready);
+    ready = Set();
+    hasReady = false;
+    return true;
+}
+
+StampMatcher::Stats StampMatcher::stats() const {
+    QMutexLocker lock(&mutex);
+    return counters;
+}
+
+void StampMatcher::reset() {
+    QMutexLocker lock(&mutex);
+    for (auto &r : rings) r.clear();
+    ready = Set();
+    hasReady = false;
+    counters = Stats();
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <QMutex>
+#include <deque>
+#include <vector>
+#include "FrameMailbox.h"
+#include "LatencyStats.h"
+
+// Groups frames of several ports that were captured together: each port
+// keeps a short ring of frames in stamp order and a set is complete when
+// every port has a frame within the tolerance of the one just pushed.
+// Only complete sets come out; frames passed over by a newer set are
+// counted as unmatched. push() runs on the port reader threads, take() on
+// the GUI thread.
+class StampMatcher {
+public:
+    struct Set {
+        std::vector<FrameMailbox::Frame> frames; // one per port, in port order
+        double skewMs{0.0}; // newest - oldest stamp of the set
+    };
+    struct Stats {
+        quint64 pushed{0};
+        quint64 matched{0};    // complete sets formed
+        quint64 unmatched{0};  // frames dropped without ever being part of a set
+        quint64 superseded{0}; // complete sets replaced before the GUI took them
+        LatencyHistogram skew;
+    };
+
+    StampMatcher(int ports, double toleranceMs, int capacity=8);
+
+    int ports() const { return int(rings.size()); }
+    // now: local arrival time, used as the stamp of unstamped frames
+    void push(int port, FrameMailbox::Frame &&frame, double now);
+    // Newest complete set formed since the last call
+    bool take(Set &out);
+    Stats stats() const;
+    void reset();
+
+private:
+    struct Entry {
+        FrameMailbox::Frame frame;
+        double stamp{0.0};
+    };
+
+    mutable QMutex mutex;
+    std::vector<std::deque<Entry>> rings; // ascending stamp per port
+    size_t capacity;
+    double tolerance; // s
+    Set ready;
+    bool hasReady{false};
+    Stats counters;
+};
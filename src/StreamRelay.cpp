@@ -0,0 +1,198 @@
+#include "StreamRelay.h"
+#include "FramePool.h"
+#include "PixelConvert.h"
+#include "Trace.h"
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Value.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+StreamRelay::StreamRelay(const Settings &s) : settings(s) {
+    settings.scale = std::clamp(settings.scale, 0.01, 1.0);
+    settings.maxRate = std::max(settings.maxRate, 0.0);
+    settings.jpegQuality = std::min(settings.jpegQuality, 100);
+    worker = std::thread([this]() { workerLoop(); });
+}
+
+StreamRelay::~StreamRelay() {
+    {
+        QMutexLocker lock(&mutex);
+        stopping = true;
+    }
+    wake.wakeAll();
+    worker.join();
+    close();
+}
+
+bool StreamRelay::open(const std::string &portName) {
+    const bool ok = settings.jpegQuality >= 0 ? jpegPort.open(portName) : rawPort.open(portName);
+    if (!ok) yError() << "Cannot open relay output port" << portName;
+    return ok;
+}
+
+void StreamRelay::close() {
+    rawPort.close();
+    jpegPort.close();
+}
+
+bool StreamRelay::admit(double now) {
+    {
+        // Worker still busy with the previous frame: skip this one before
+        // anything is copied, the pending frame goes out first
+        QMutexLocker lock(&mutex);
+        if (hasPending) {
+            counters.superseded++;
+            return false;
+        }
+    }
+    if (settings.maxRate <= 0.0) return true;
+    // A little slack so a source at exactly the limit is not halved by jitter
+    if (lastAccepted >= 0.0 && now - lastAccepted < 0.9 / settings.maxRate) {
+        QMutexLocker lock(&mutex);
+        counters.decimated++;
+        return false;
+    }
+    lastAccepted = now;
+    return true;
+}
+
+namespace {
+QImage pooledCopy(const unsigned char *src, size_t stride, int w, int h, QImage::Format fmt, int rowBytes) {
+    QImage copy = FramePool::instance().acquire(w, h, fmt);
+    for (int y=0; y<h; ++y) {
+        std::memcpy(copy.scanLine(y), src + size_t(y)*stride, size_t(rowBytes));
+    }
+    return copy;
+}
+}
+
+void StreamRelay::offer(const yarp::sig::Image &img, const yarp::os::Stamp &stamp, double now) {
+    if (!admit(now)) return;
+    Trace::Scope trace("relayOffer", stamp.getCount());
+    const int w = int(img.width());
+    const int h = int(img.height());
+    const unsigned char *src = img.getRawImage();
+    const size_t stride = img.getRowSize();
+    // Same formats as the receiver's conversion: alpha that is not used (junk
+    // or zero) must not be premultiplied by the scaler
+    QImage::Format fmt;
+    int bpp;
+    switch (img.getPixelCode()) {
+    case VOCAB_PIXEL_BGRA: // BGRA bytes, little endian
+        fmt = PixelConvert::alphaUnused(src, stride, w, h, 3) ? QImage::Format_RGB32 : QImage::Format_ARGB32;
+        bpp = 4;
+        break;
+    case VOCAB_PIXEL_RGBA:
+        fmt = PixelConvert::alphaUnused(src, stride, w, h, 3) ? QImage::Format_RGBX8888 : QImage::Format_RGBA8888;
+        bpp = 4;
+        break;
+    case VOCAB_PIXEL_RGB:  fmt = QImage::Format_RGB888; bpp = 3; break;
+    case VOCAB_PIXEL_BGR:  fmt = QImage::Format_BGR888; bpp = 3; break;
+    case VOCAB_PIXEL_MONO: fmt = QImage::Format_Grayscale8; bpp = 1; break;
+    default:               fmt = QImage::Format_Invalid; bpp = 0; break;
+    }
+    // The port buffer is reused once onRead returns: the worker gets a copy
+    // in a pooled buffer, so the steady state allocates nothing
+    QImage copy;
+    if (fmt != QImage::Format_Invalid) {
+        copy = pooledCopy(src, stride, w, h, fmt, w*bpp);
+    } else if (genericScratch.copy(img)) {
+        // Depth, float and the rare codes: YARP's own conversion to RGB
+        copy = pooledCopy(genericScratch.getRawImage(), genericScratch.getRowSize(), w, h, QImage::Format_RGB888, w*3);
+    } else {
+        return;
+    }
+    post(std::move(copy), QSize(w, h), stamp);
+}
+
+void StreamRelay::offer(const QImage &img, const QSize &fullSize, const yarp::os::Stamp &stamp, double now) {
+    if (img.isNull() || !admit(now)) return;
+    post(QImage(img), fullSize.isValid() ? fullSize : img.size(), stamp);
+}
+
+void StreamRelay::post(QImage &&img, const QSize &fullSize, const yarp::os::Stamp &stamp) {
+    QMutexLocker lock(&mutex);
+    if (hasPending) counters.superseded++;
+    pending = std::move(img);
+    pendingFullSize = fullSize;
+    pendingStamp = stamp;
+    hasPending = true;
+    wake.wakeAll();
+}
+
+StreamRelay::Stats StreamRelay::stats() const {
+    QMutexLocker lock(&mutex);
+    return counters;
+}
+
+void StreamRelay::workerLoop() {
+    if (Trace::enabled()) Trace::setThreadName("relay");
+    QMutexLocker lock(&mutex);
+    for (;;) {
+        if (stopping) break;
+        if (!hasPending) {
+            wake.wait(&mutex);
+            continue;
+        }
+        QImage img = std::move(pending);
+        pending = QImage();
+        const QSize fullSize = pendingFullSize;
+        const yarp::os::Stamp stamp = pendingStamp;
+        hasPending = false;
+        lock.unlock();
+        publish(img, fullSize, stamp);
+        lock.relock();
+    }
+}
+
+void StreamRelay::publish(const QImage &src, const QSize &fullSize, const yarp::os::Stamp &stamp) {
+    Trace::Scope trace("relayPublish", stamp.getCount());
+    QElapsedTimer timer;
+    timer.start();
+    // Target from the stream resolution: a decoded frame may already be smaller
+    const QSize target(std::max(1, int(std::lround(fullSize.width() * settings.scale))),
+                       std::max(1, int(std::lround(fullSize.height() * settings.scale))));
+    const bool gray = src.format() == QImage::Format_Grayscale8;
+    QImage out = src;
+    if (src.width() > target.width() || src.height() > target.height()) {
+        out = scaler.scale(src, src.size().scaled(target, Qt::KeepAspectRatio), ScaleKernels::Kernel::Area);
+    }
+    out = out.convertToFormat(gray ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+
+    yarp::os::Stamp envelope = stamp;
+    qsizetype bytes = 0;
+    if (settings.jpegQuality >= 0) {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        if (!out.save(&buffer, "JPG", settings.jpegQuality)) return;
+        yarp::os::Bottle &b = jpegPort.prepare();
+        b.clear();
+        b.add(yarp::os::Value(data.data(), int(data.size())));
+        jpegPort.setEnvelope(envelope);
+        jpegPort.write();
+        bytes = data.size();
+    } else {
+        yarp::sig::FlexImage &img = rawPort.prepare();
+        img.setPixelCode(gray ? VOCAB_PIXEL_MONO : VOCAB_PIXEL_RGB);
+        img.resize(size_t(out.width()), size_t(out.height()));
+        const size_t rowBytes = size_t(out.width()) * (gray ? 1 : 3);
+        for (int y=0; y<out.height(); ++y) {
+            std::memcpy(img.getRawImage() + size_t(y)*img.getRowSize(), out.constScanLine(y), rowBytes);
+        }
+        rawPort.setEnvelope(envelope);
+        rawPort.write();
+        bytes = qsizetype(rowBytes) * out.height();
+    }
+    const double ms = timer.nsecsElapsed() / 1e6;
+
+    QMutexLocker lock(&mutex);
+    counters.published++;
+    counters.bytes += quint64(bytes);
+    counters.workMs = counters.workMs>0 ? 0.9*counters.workMs + 0.1*ms : ms;
+    counters.size = out.size();
+}
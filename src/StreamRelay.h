@@ -0,0 +1,71 @@
+#pragma once
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+#include <string>
+#include <thread>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/sig/Image.h>
+#include "ImageScaler.h"
+
+// Re-publishes the incoming stream, reduced for thin remote viewers: scaled,
+// rate-limited and optionally JPEG-encoded (a blob in a Bottle, as read by
+// --compressed). offer() is called by the port reader thread and only copies
+// the frame into a single pending slot; scaling, encoding and the write run
+// on a worker thread. A frame offered while the previous one is still
+// pending is skipped without being copied. The envelope stamp of the source
+// frame is kept.
+class StreamRelay {
+public:
+    struct Settings {
+        double scale = 0.5;    // of the source resolution, (0, 1]
+        double maxRate = 0.0;  // frames per second, 0 = every frame
+        int jpegQuality = -1;  // 0-100, -1 = raw pixels (RGB or MONO)
+    };
+
+    struct Stats {
+        quint64 published{0};
+        quint64 decimated{0};  // skipped by the rate limit
+        quint64 superseded{0}; // skipped while a frame was pending (worker busy)
+        quint64 bytes{0};      // payload written
+        double workMs{0.0};    // smoothed scale + encode time per frame
+        QSize size;            // of the last frame published
+    };
+
+    explicit StreamRelay(const Settings &s);
+    ~StreamRelay();
+
+    bool open(const std::string &portName);
+    void close();
+
+    // Native frame (reader thread)
+    void offer(const yarp::sig::Image &img, const yarp::os::Stamp &stamp, double now);
+    // Decoded frame (compressed input); fullSize: stream resolution
+    void offer(const QImage &img, const QSize &fullSize, const yarp::os::Stamp &stamp, double now);
+    Stats stats() const;
+
+private:
+    bool admit(double now);
+    void post(QImage &&img, const QSize &fullSize, const yarp::os::Stamp &stamp);
+    void workerLoop();
+    void publish(const QImage &src, const QSize &fullSize, const yarp::os::Stamp &stamp);
+
+    Settings settings;
+    yarp::os::BufferedPort<yarp::sig::FlexImage> rawPort;
+    yarp::os::BufferedPort<yarp::os::Bottle> jpegPort;
+    yarp::sig::ImageOf<yarp::sig::PixelRgb> genericScratch; // reader thread only
+    ImageScaler scaler;                                     // worker thread only
+    double lastAccepted{-1.0};                              // reader thread only
+
+    mutable QMutex mutex;
+    QWaitCondition wake;
+    QImage pending;              // guarded by mutex
+    QSize pendingFullSize;
+    yarp::os::Stamp pendingStamp;
+    bool hasPending{false};
+    bool stopping{false};
+    Stats counters;
+    std::thread worker;
+};
@@ -0,0 +1,142 @@
+#include "Trace.h"
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <yarp/os/LogStream.h>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Trace {
+
+namespace detail {
+std::atomic<bool> enabled{false};
+}
+
+namespace {
+struct Event {
+    const char *name;
+    std::int64_t begin;
+    std::int64_t dur; // -1: instant
+    std::int64_t id;
+};
+
+// Ring of the most recent events of one thread: a stutter is usually looked
+// at right after it happened, so old events are the ones to give up.
+constexpr size_t CAPACITY = size_t(1) << 17;
+
+struct ThreadBuffer {
+    explicit ThreadBuffer(int tid) : tid(tid), events(CAPACITY) {}
+    const int tid;
+    char name[32] = {};
+    std::vector<Event> events;
+    std::atomic<size_t> count{0}; // written by the owning thread only
+};
+
+struct Registry {
+    QMutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers; // outlive their threads
+    QString path;
+    std::int64_t originNs{0};
+};
+
+Registry &registry() {
+    static Registry r;
+    return r;
+}
+
+ThreadBuffer *threadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        Registry &r = registry();
+        QMutexLocker lock(&r.mutex);
+        buffer = std::make_shared<ThreadBuffer>(int(r.buffers.size()) + 1);
+        r.buffers.push_back(buffer);
+    }
+    return buffer.get();
+}
+}
+
+void detail::record(const char *name, std::int64_t beginNs, std::int64_t durNs, std::int64_t id) {
+    ThreadBuffer *b = threadBuffer();
+    const size_t i = b->count.load(std::memory_order_relaxed);
+    b->events[i & (CAPACITY - 1)] = Event{name, beginNs, durNs, id};
+    b->count.store(i + 1, std::memory_order_release);
+}
+
+void setThreadName(const char *name) {
+    ThreadBuffer *b = threadBuffer();
+    std::strncpy(b->name, name, sizeof(b->name) - 1);
+}
+
+bool start(const QString &path) {
+    Registry &r = registry();
+    {
+        QMutexLocker lock(&r.mutex);
+        QFile probe(path);
+        if (!probe.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            yError() << "Cannot create trace file" << path.toStdString();
+            return false;
+        }
+        r.path = path;
+        r.originNs = detail::nowNs();
+        for (auto &b : r.buffers) b->count.store(0, std::memory_order_relaxed);
+    }
+    detail::enabled.store(true);
+    return true;
+}
+
+void stop() {
+    if (!detail::enabled.exchange(false)) return;
+    Registry &r = registry();
+    QMutexLocker lock(&r.mutex);
+    QFile f(r.path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        yError() << "Cannot write trace file" << r.path.toStdString();
+        return;
+    }
+    auto us = [&r](std::int64_t ns) { return QByteArray::number(double(ns - r.originNs) / 1000.0, 'f', 3); };
+    QByteArray out;
+    out.reserve(1 << 20);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto sep = [&out, &first]() { if (!first) out += ",\n"; first = false; };
+    quint64 total = 0, lost = 0;
+    for (const auto &b : r.buffers) {
+        const size_t n = b->count.load(std::memory_order_acquire);
+        const size_t begin = n > CAPACITY ? n - CAPACITY : 0;
+        if (n == 0) continue;
+        const QByteArray tid = QByteArray::number(b->tid);
+        if (b->name[0]) {
+            sep();
+            out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid
+                 + ",\"args\":{\"name\":\"" + QByteArray(b->name).replace('"', '\'') + "\"}}";
+        }
+        for (size_t i=begin; i<n; ++i) {
+            const Event &e = b->events[i & (CAPACITY - 1)];
+            sep();
+            out += "{\"name\":\"";
+            out += e.name;
+            out += "\",\"pid\":1,\"tid\":" + tid + ",\"ts\":" + us(e.begin);
+            if (e.dur < 0) out += ",\"ph\":\"i\",\"s\":\"t\"";
+            else out += ",\"ph\":\"X\",\"dur\":" + QByteArray::number(double(e.dur) / 1000.0, 'f', 3);
+            if (e.id >= 0) out += ",\"args\":{\"frame\":" + QByteArray::number(qint64(e.id)) + "}";
+            out += "}";
+            if (out.size() > (1 << 20)) {
+                f.write(out);
+                out.clear();
+            }
+        }
+        total += n - begin;
+        lost += begin;
+        b->count.store(0, std::memory_order_relaxed);
+    }
+    out += "\n]}\n";
+    f.write(out);
+    yInfo() << "Trace:" << total << "events written to" << r.path.toStdString()
+            << (lost ? "(" + std::to_string(lost) + " older events overwritten)" : std::string());
+}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Pipeline tracing in Chrome trace-event JSON (opens in Perfetto / about:tracing).
+// Each thread appends complete events to its own fixed-size buffer without
+// locking; stop() collects all buffers and writes the file. When tracing is
+// off a Scope costs one relaxed atomic load.
+namespace Trace {
+
+namespace detail {
+extern std::atomic<bool> enabled;
+inline std::int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+void record(const char *name, std::int64_t beginNs, std::int64_t durNs, std::int64_t id);
+}
+
+inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+bool start(const QString &path);
+// Stops recording and writes the JSON file. Safe to call when not started.
+void stop();
+
+// Label the calling thread in the trace (copied; call once per thread).
+void setThreadName(const char *name);
+
+// For per-frame code on threads it does not own (port callbacks, pools):
+// labels the calling thread on its first call while tracing, then costs a
+// thread-local check.
+inline void nameThreadOnce(const char *name) {
+    thread_local bool named = false;
+    if (named || !enabled()) return;
+    setThreadName(name);
+    named = true;
+}
+
+// Zero-duration marker
+inline void instant(const char *name, std::int64_t id=-1) {
+    if (enabled()) detail::record(name, detail::nowNs(), -1, id);
+}
+
+// Complete event spanning the scope. id is a frame id (envelope sequence
+// number) shown as args.frame, -1 for none. name must be a string literal.
+class Scope {
+public:
+    explicit Scope(const char *name, std::int64_t id=-1)
+        : name(enabled() ? name : nullptr), id(id) {
+        if (this->name) begin = detail::nowNs();
+    }
+    ~Scope() {
+        if (name) detail::record(name, begin, detail::nowNs() - begin, id);
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    void setId(std::int64_t frameId) { id = frameId; }
+
+private:
+    const char *name;
+    std::int64_t id;
+    std::int64_t begin{0};
+};
+
+}
@@ -0,0 +1,42 @@
+#include <QCoreApplication>
+#include "Options.h"
+#include "HeadlessViewer.h"
+#include "Trace.h"
+#include <yarp/os/Network.h>
+#include <cstdlib>
+
+// yarpview-qt6 without the window: links neither QtWidgets nor a platform
+// plugin, so it starts on machines without a display
+int main(int argc, char **argv) {
+    yarp::os::Network yarp;
+    QCoreApplication app(argc, argv);
+
+    yarp::os::ResourceFinder rf;
+    auto options = OptionsParser::parse(argc, argv, rf);
+    if (options.helpRequested) {
+        OptionsParser::printHelp();
+        return EXIT_SUCCESS;
+    }
+    if (!options.error.empty()) {
+        fprintf(stderr, "%s\n", options.error.c_str());
+        return EXIT_FAILURE;
+    }
+    // Playback of a recording works without a name server
+    if (options.replayFile.empty() && !yarp.checkNetwork()) {
+        fprintf(stderr, "YARP network not available.\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!options.traceFile.empty()) {
+        // Trace::start() reports a file it cannot create
+        if (Trace::start(QString::fromStdString(options.traceFile))) Trace::setThreadName("main");
+    }
+
+    int ret;
+    {
+        HeadlessViewer v(options);
+        ret = v.isRunning() ? app.exec() : EXIT_FAILURE;
+    }
+    Trace::stop(); // after the viewer has shut its threads down
+    return ret;
+}
@@ -1,16 +1,44 @@
 #include <QApplication>
 #include "Options.h"
 #include "MainWindow.h"
+#include "Trace.h"
 #include <yarp/os/Network.h>
 #include <cstdlib>  // for EXIT_FAILURE / EXIT_SUCCESS
+#include <cstring>
+#include <string>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
 
-int main(int argc, char **argv) {
-    yarp::os::Network yarp;
-    if (!yarp.checkNetwork()) {
-        fprintf(stderr, "YARP network not available.\n");
-        return EXIT_FAILURE; // was: return 1;
+namespace {
+// Hands --headless over to yarpview-qt6-headless (next to this binary, else
+// on the PATH) before any Qt platform code runs: QApplication would abort
+// on a machine without a display
+int runHeadless(char **argv) {
+#ifdef Q_OS_UNIX
+    const char *exe = "yarpview-qt6-headless";
+    const std::string self = argv[0];
+    const size_t slash = self.rfind('/');
+    if (slash != std::string::npos) {
+        const std::string sibling = self.substr(0, slash + 1) + exe;
+        argv[0] = const_cast<char*>(sibling.c_str());
+        execv(sibling.c_str(), argv);
     }
+    argv[0] = const_cast<char*>(exe);
+    execvp(exe, argv);
+#else
+    Q_UNUSED(argv);
+#endif
+    fprintf(stderr, "--headless: run yarpview-qt6-headless with the same options instead.\n");
+    return EXIT_FAILURE;
+}
+}
 
+int main(int argc, char **argv) {
+    for (int i=1; i<argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) return runHeadless(argv);
+    }
+    yarp::os::Network yarp;
     QApplication app(argc, argv);
 
     yarp::os::ResourceFinder rf;
@@ -19,9 +47,27 @@ int main(int argc, char **argv) {
         OptionsParser::printHelp();
         return EXIT_SUCCESS;
     }
+    if (!options.error.empty()) {
+        fprintf(stderr, "%s\n", options.error.c_str());
+        return EXIT_FAILURE;
+    }
+    // Playback of a recording works without a name server
+    if (options.replayFile.empty() && !yarp.checkNetwork()) {
+        fprintf(stderr, "YARP network not available.\n");
+        return EXIT_FAILURE; // was: return 1;
+    }
 
-    MainWindow w(options);
-    w.show();
+    if (!options.traceFile.empty()) {
+        // Trace::start() reports a file it cannot create
+        if (Trace::start(QString::fromStdString(options.traceFile))) Trace::setThreadName("gui");
+    }
 
-    return app.exec(); // returns 0 (EXIT_SUCCESS) on normal exit
+    int ret;
+    {
+        MainWindow w(options);
+        w.show();
+        ret = app.exec(); // returns 0 (EXIT_SUCCESS) on normal exit
+    }
+    Trace::stop(); // after the window has shut its threads down
+    return ret;
 }
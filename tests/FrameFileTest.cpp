@@ -0,0 +1,130 @@
+#include "FrameFile.h"
+#include <QTemporaryDir>
+#include <cstddef>
+#include <cstdio>
+#include <yarp/sig/Image.h>
+
+// Round trip through a recording, then the two ways a file goes bad: a
+// writer that never closed it (no index, frames recovered by scanning) and
+// a damaged frame header (playback ends at the frame before it).
+namespace {
+constexpr int FRAMES = 6;
+constexpr int W = 5; // odd width: YARP pads the rows, the file does not
+constexpr int H = 3;
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+unsigned char value(int frame, int x, int y, int c) { return (unsigned char)(frame*31 + y*W*3 + x*3 + c); }
+
+// Writes the test frames, returns the file size before the index
+quint64 write(const QString &path) {
+    FrameFile::Writer w;
+    if (!w.open(path)) return 0;
+    yarp::sig::ImageOf<yarp::sig::PixelRgb> img;
+    img.resize(W, H);
+    for (int i=0; i<FRAMES; ++i) {
+        for (int y=0; y<H; ++y) {
+            for (int x=0; x<W; ++x) {
+                img.pixel(x, y) = yarp::sig::PixelRgb(value(i, x, y, 0), value(i, x, y, 1), value(i, x, y, 2));
+            }
+        }
+        if (!w.append(img, yarp::os::Stamp(100 + i, 10.0 + 0.04*i))) return 0;
+    }
+    const quint64 records = w.bytes();
+    w.close();
+    return records;
+}
+
+// Frames 0..count-1 of the reader are the ones written
+bool framesMatch(const FrameFile::Reader &r, size_t count) {
+    if (r.frameCount() != count) return false;
+    for (size_t i=0; i<count; ++i) {
+        yarp::sig::FlexImage img;
+        yarp::os::Stamp stamp;
+        if (!r.frame(i, img, stamp)) return false;
+        if (stamp.getCount() != 100 + int(i) || stamp.getTime() != 10.0 + 0.04*int(i)) return false;
+        if (img.width() != size_t(W) || img.height() != size_t(H) || img.getPixelCode() != VOCAB_PIXEL_RGB) return false;
+        for (int y=0; y<H; ++y) {
+            for (int x=0; x<W; ++x) {
+                const unsigned char *p = img.getPixelAddress(x, y);
+                for (int c=0; c<3; ++c) {
+                    if (p[c] != value(int(i), x, y, c)) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool patch(const QString &path, quint64 pos, const void *data, qint64 n) {
+    QFile f(path);
+    return f.open(QIODevice::ReadWrite) && f.seek(qint64(pos))
+        && f.write(static_cast<const char*>(data), n) == n;
+}
+}
+
+int main() {
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "no temporary directory\n");
+        return 1;
+    }
+    const QString path = dir.filePath("frames.yvf");
+    const int bad = 3;
+    const std::uint32_t junk = 0xdeadbeef;
+
+    // Read through the index
+    check(write(path) > 0, "recording written");
+    std::uint64_t badOffset = 0;
+    {
+        FrameFile::Reader r;
+        check(r.open(path) && framesMatch(r, FRAMES), "indexed frames read back");
+        if (r.frameCount() == FRAMES) badOffset = r.entry(bad).offset;
+    }
+    check(badOffset > 0, "offset of the frame to corrupt");
+
+    // Record size that disagrees with the frame size: indexed playback stops before it
+    const std::uint64_t dataBytes = 1;
+    check(patch(path, badOffset + offsetof(FrameFile::FrameHeader, dataBytes), &dataBytes, sizeof(dataBytes)), "header patched");
+    {
+        FrameFile::Reader r;
+        check(r.open(path) && framesMatch(r, bad), "indexed playback ends before the corrupt frame");
+    }
+
+    // Writer never closed: no index and footer, every frame recovered by scanning
+    const quint64 records = write(path);
+    check(records > 0 && QFile::resize(path, qint64(records)), "index cut off");
+    {
+        FrameFile::Reader r;
+        check(r.open(path) && framesMatch(r, FRAMES), "frames recovered without the index");
+    }
+
+    // Last record cut short, as by a crash during the write
+    check(QFile::resize(path, qint64(records) - 1), "file truncated");
+    {
+        FrameFile::Reader r;
+        check(r.open(path) && framesMatch(r, FRAMES - 1), "partial last frame dropped");
+    }
+
+    // Bad magic: the scan stops at it
+    check(patch(path, badOffset, &junk, sizeof(junk)), "magic patched");
+    {
+        FrameFile::Reader r;
+        check(r.open(path) && framesMatch(r, bad), "scan ends before the corrupt frame");
+    }
+
+    // Nothing before the first frame record
+    check(patch(path, FrameFile::RECORD_ALIGN, &junk, sizeof(junk)), "first magic patched");
+    {
+        FrameFile::Reader r;
+        check(!r.open(path), "file without a readable frame is refused");
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,52 @@
+#include "FramePool.h"
+#include <cstdio>
+
+// Alternating two frame sizes (a mosaic tile and the main stream, or a
+// convert buffer and its ingest reduction) must be served from the pool
+// once both sizes have been seen, not freed and reallocated every frame.
+int main() {
+    FramePool &pool = FramePool::instance();
+    auto cycle = [&pool]() {
+        QImage big = pool.acquire(1920, 1080, QImage::Format_RGB32);
+        big.bits()[0] = 1;
+        big = QImage();
+        QImage small = pool.acquire(640, 360, QImage::Format_RGB32);
+        small.bits()[0] = 1;
+    };
+    cycle(); // first use of each size allocates
+    const FramePool::Stats warm = pool.stats();
+    for (int i=0; i<100; ++i) cycle();
+    const FramePool::Stats s = pool.stats();
+    if (s.misses != warm.misses) {
+        std::fprintf(stderr, "alternating sizes allocated %llu more buffers\n",
+                     (unsigned long long)(s.misses - warm.misses));
+        return 1;
+    }
+    if (s.hits - warm.hits != 200 || s.residentBytes != warm.residentBytes) {
+        std::fprintf(stderr, "unexpected pool accounting: %llu hits, %lld resident bytes (was %lld)\n",
+                     (unsigned long long)(s.hits - warm.hits), (long long)s.residentBytes, (long long)warm.residentBytes);
+        return 1;
+    }
+
+    // Ingest reduction: the full-size conversion is still held while the
+    // reduced buffer is taken, and the reduced frame outlives it (it sits
+    // in the mailbox until the next one replaces it)
+    QImage shown;
+    auto reduce = [&pool, &shown]() {
+        QImage full = pool.acquire(3840, 2160, QImage::Format_RGB32);
+        QImage reduced = pool.acquire(960, 540, QImage::Format_RGB32);
+        full.bits()[0] = reduced.bits()[0] = 1;
+        shown = reduced;
+    };
+    reduce();
+    reduce();
+    const FramePool::Stats before = pool.stats();
+    for (int i=0; i<100; ++i) reduce();
+    const FramePool::Stats after = pool.stats();
+    if (after.misses != before.misses) {
+        std::fprintf(stderr, "convert and reduce allocated %llu more buffers\n",
+                     (unsigned long long)(after.misses - before.misses));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "JitterBuffer.h"
+#include <cmath>
+#include <cstdio>
+
+// Synthetic clocks: publisher stamps at 10 Hz, local time 100 s ahead plus
+// a varying transit. Frames must come out at stamp + smallest transit of the
+// last OFFSET_WINDOW_S + target delay, and the counters must follow drops,
+// bursts and a publisher restart.
+namespace {
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+bool near(double a, double b) { return std::abs(a - b) < 1e-6; }
+
+void push(JitterBuffer &jb, int seq, double stamp, double now) {
+    FrameMailbox::Frame f;
+    f.stamp = yarp::os::Stamp(seq, stamp);
+    jb.push(std::move(f), now);
+}
+
+// Takes at now and returns the stamp of the frame shown, -1 if none
+double take(JitterBuffer &jb, double now, double &nextDue) {
+    FrameMailbox::Frame f;
+    return jb.take(now, f, nextDue) ? f.stamp.getTime() : -1.0;
+}
+}
+
+int main() {
+    JitterBuffer jb(4);
+    jb.setTargetDelay(50.0);
+    double next = 0.0;
+
+    // Released at stamp + offset (transit 100.03) + delay
+    push(jb, 0, 1.0, 101.03);
+    check(take(jb, 101.079, next) < 0.0, "held until due");
+    check(near(next, 101.08), "due at stamp + offset + delay");
+    check(near(take(jb, 101.081, next), 1.0), "released when due");
+    check(next == 0.0, "nothing buffered");
+
+    // A faster transit lowers the offset at once, a slower one does not raise it
+    push(jb, 1, 1.1, 101.12);
+    check(take(jb, 101.169, next) < 0.0 && near(next, 101.17), "offset follows the smaller transit");
+    check(near(take(jb, 101.171, next), 1.1), "second frame released");
+    push(jb, 2, 1.2, 101.25);
+    check(take(jb, 101.269, next) < 0.0 && near(next, 101.27), "slower transit keeps the minimum");
+    check(near(take(jb, 101.271, next), 1.2), "third frame released");
+
+    // Five seconds later the old minimum has left the window; the frame
+    // after the one on screen was due long ago: an underrun
+    push(jb, 52, 6.2, 106.26);
+    check(take(jb, 106.309, next) < 0.0 && near(next, 106.31), "window minimum expires");
+    check(jb.stats().underruns == 1, "gap in the stream counted as underrun");
+    check(near(take(jb, 106.311, next), 6.2), "frame after the gap released");
+
+    // Not newer than the frame on screen
+    push(jb, 52, 6.2, 106.35);
+    check(jb.stats().late == 1, "repeated frame is late");
+
+    // Behind schedule: only the newest due frame is shown
+    push(jb, 53, 6.3, 106.37);
+    push(jb, 54, 6.4, 106.47);
+    push(jb, 55, 6.5, 106.57);
+    check(near(take(jb, 106.62, next), 6.5), "newest due frame taken");
+    check(jb.stats().superseded == 2, "older due frames superseded");
+
+    // A burst beyond the capacity drops the oldest frames
+    for (int i=0; i<5; ++i) push(jb, 56 + i, 6.6 + 0.1*i, 106.67 + 0.1*i);
+    JitterBuffer::Stats s = jb.stats();
+    check(s.overruns == 1 && s.depth == 4, "burst overruns the buffer");
+    check(near(take(jb, 107.2, next), 7.0), "burst drained to its newest frame");
+    check(jb.stats().superseded == 5, "drained frames superseded");
+
+    // Stamps going back: the offset and the frame on screen start over,
+    // the counters are kept
+    push(jb, 0, 0.5, 107.3);
+    check(take(jb, 107.349, next) < 0.0 && near(next, 107.35), "offset re-estimated after restart");
+    check(near(take(jb, 107.351, next), 0.5), "restarted stream is not late");
+    s = jb.stats();
+    check(s.late == 1 && s.overruns == 1 && s.underruns == 1 && s.superseded == 5, "counters kept across restart");
+
+    jb.clear();
+    s = jb.stats();
+    check(s.late == 0 && s.superseded == 0 && s.depth == 0 && near(s.delayMs, 50.0), "clear resets counters, keeps delay");
+    return failures ? 1 : 0;
+}
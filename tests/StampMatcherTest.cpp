@@ -0,0 +1,94 @@
+#include "StampMatcher.h"
+#include <cmath>
+#include <cstdio>
+
+// Skewed stamp sequences on two and three ports: set completion within the
+// tolerance, the closest-partner pick, and the unmatched / superseded counts.
+namespace {
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+bool near(double a, double b) { return std::abs(a - b) < 1e-6; }
+
+void push(StampMatcher &m, int port, int seq, double t) {
+    FrameMailbox::Frame f;
+    f.stamp = yarp::os::Stamp(seq, t);
+    m.push(port, std::move(f), t);
+}
+
+double stampOf(const StampMatcher::Set &s, int port) { return s.frames[size_t(port)].stamp.getTime(); }
+
+void twoPorts() {
+    StampMatcher m(2, 5.0);
+    StampMatcher::Set set;
+    push(m, 0, 0, 1.000);
+    check(!m.take(set), "no set before the second port has a frame");
+    push(m, 1, 0, 1.003);
+    check(m.stats().matched == 1, "frames 3 ms apart match within 5 ms");
+
+    // Port 1 misses a frame: port 0's 1.033 is passed over by the next set
+    push(m, 0, 1, 1.033);
+    push(m, 0, 2, 1.066);
+    push(m, 1, 1, 1.068);
+    StampMatcher::Stats s = m.stats();
+    check(s.matched == 2, "second set formed");
+    check(s.superseded == 1, "first set replaced before it was taken");
+    check(s.unmatched == 1, "frame passed over by a newer set is unmatched");
+    check(m.take(set), "newest set is taken");
+    check(near(stampOf(set, 0), 1.066) && near(stampOf(set, 1), 1.068), "closest partner picked");
+    check(near(set.skewMs, 2.0), "skew of the set is newest - oldest stamp");
+    check(!m.take(set), "a set is taken only once");
+
+    // 10 ms apart is outside the tolerance; the next frame of port 0 pairs
+    // with port 1 and the older one is unmatched
+    push(m, 0, 3, 1.100);
+    push(m, 1, 2, 1.110);
+    check(m.stats().matched == 2, "frames 10 ms apart do not match");
+    push(m, 0, 4, 1.111);
+    s = m.stats();
+    check(s.matched == 3 && s.superseded == 1 && s.unmatched == 2, "later frame completes the set");
+    check(m.take(set) && near(set.skewMs, 1.0), "skew 1 ms");
+    check(s.skew.count() == 3 && near(s.skew.max(), 3.0), "skew histogram holds every set");
+
+    // Stamps going back more than a second on one port: its ring restarts
+    push(m, 1, 3, 2.000);
+    push(m, 1, 0, 0.500);
+    s = m.stats();
+    check(s.unmatched == 3, "restart drops the port's buffered frames");
+    push(m, 0, 0, 0.501);
+    check(m.stats().matched == 4, "restarted port matches again");
+    check(m.take(set) && near(stampOf(set, 1), 0.500), "set formed with the restarted stamp");
+    check(m.stats().pushed == 11, "every push counted");
+}
+
+void threePorts() {
+    // Capacity 2: a port running ahead loses its oldest frames
+    StampMatcher m(3, 4.0, 2);
+    StampMatcher::Set set;
+    push(m, 0, 0, 5.000);
+    push(m, 0, 1, 5.010);
+    push(m, 0, 2, 5.020);
+    check(m.stats().unmatched == 1, "ring overflow counts as unmatched");
+    push(m, 1, 0, 5.021);
+    check(m.stats().matched == 0, "two of three ports do not make a set");
+    push(m, 2, 0, 5.018);
+    StampMatcher::Stats s = m.stats();
+    check(s.matched == 1, "third port completes the set");
+    check(s.unmatched == 2, "port 0 frame before the pick is unmatched");
+    check(m.take(set) && set.frames.size() == 3, "one frame per port");
+    check(near(stampOf(set, 0), 5.020) && near(stampOf(set, 1), 5.021) && near(stampOf(set, 2), 5.018), "set frames");
+    check(near(set.skewMs, 3.0), "skew over three ports");
+}
+}
+
+int main() {
+    twoPorts();
+    threePorts();
+    return failures ? 1 : 0;
+}